@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright 2017 Tim Prince
+#
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+#
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this software; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+#
+
+'''
+Measures ook.decode throughput for each supported input sample type.
+
+A single transmission is rendered once with ook.packet_source, quantised
+to each sample type and then replayed through the matching decoder until
+the requested number of samples has been consumed.
+'''
+
+from __future__ import print_function
+
+import argparse
+import time
+
+from gnuradio import gr, blocks
+import ook
+
+VARIANTS = [
+    ('float', blocks.vector_source_f, ook.decode, 1.0),
+    ('int16', blocks.vector_source_s, ook.decode_s, 32767),
+    ('int8', blocks.vector_source_b, ook.decode_b, 127),
+]
+
+
+def render(payload, sample_rate):
+    tb = gr.top_block()
+    src = ook.packet_source(payload, 1, 10, sample_rate)
+    sink = blocks.vector_sink_f()
+    tb.connect(src, sink)
+    tb.run()
+    return list(sink.data())
+
+
+def run_variant(samples, make_source, make_decode, tolerance, count):
+    tb = gr.top_block()
+    src = make_source(samples, True)
+    head = blocks.head(src.output_signature().sizeof_stream_item(0), count)
+    decode = make_decode(tolerance)
+    tb.connect(src, head, decode)
+
+    start = time.time()
+    tb.run()
+    return time.time() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--samples', type=int, default=100000000)
+    parser.add_argument('--sample-rate', type=int, default=32000)
+    parser.add_argument('--tolerance', type=float, default=0.1)
+    args = parser.parse_args()
+
+    envelope = render([0x12, 0x34, 0x56, 0x78, 0x9A], args.sample_rate)
+
+    baseline = None
+    for name, make_source, make_decode, scale in VARIANTS:
+        samples = [int(round(x * scale)) if scale != 1.0 else x
+                   for x in envelope]
+        elapsed = run_variant(
+            samples, make_source, make_decode, args.tolerance, args.samples)
+        rate = args.samples / elapsed / 1e6
+        baseline = baseline or rate
+        print('{:6s} {:8.2f} Msamples/s ({:.2f}x float)'.format(
+            name, rate, rate / baseline))
+
+
+if __name__ == '__main__':
+    main()
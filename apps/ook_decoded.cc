@@ -0,0 +1,655 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * ook_decoded: decode many sample streams without a flowgraph.
+ *
+ * Each input is a named pipe, a regular file or '-' for stdin, holding
+ * either float32 envelope samples or interleaved unsigned 8-bit I/Q
+ * (as written by rtl_sdr). Pipes are watched with epoll; whenever one
+ * becomes readable, a task that drains it into the stream's own
+ * ook::stream_decoder is queued on a fixed pool of work-stealing
+ * threads. Each stream is handled by at most one task at a time, so its
+ * packets come out in order. Regular files cannot be polled and are
+ * simply read chunk by chunk until they end. A named pipe whose writer
+ * goes away is reopened to wait for the next one, unless -x is given;
+ * each writer's samples are numbered from zero.
+ *
+ * Packets are written to stdout, either as JSON lines or as binary
+ * records: a little-endian uint32 stream index, four reserved bytes and
+ * a packet log record as described in ook/packet_log.h.
+ */
+
+#include <ook/packet_log.h>
+#include <ook/stream_decoder.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace gr;
+
+namespace
+{
+/* Bytes read from one stream before its task yields to the others. */
+const size_t max_batch = 1 << 20;
+const size_t read_size = 1 << 16;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int)
+{
+    stop_requested = 1;
+}
+
+/*
+ * A fixed set of threads, each with its own task queue. Workers take
+ * tasks from the front of their own queue and, when it is empty, steal
+ * from the back of the others'. Tasks submitted from a worker go to
+ * that worker's queue; others are spread round robin.
+ */
+class work_pool
+{
+  public:
+    typedef std::function<void()> task;
+
+    explicit work_pool(unsigned count)
+    {
+        for (unsigned i = 0; i < count; ++i) {
+            queues.emplace_back(new queue);
+        }
+        for (unsigned i = 0; i < count; ++i) {
+            threads.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    ~work_pool()
+    {
+        stop();
+    }
+
+    /* Run the queued tasks, then join the threads. */
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(idle_lock);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (auto& thread : threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    void submit(task t)
+    {
+        size_t index =
+          current >= 0 ? (size_t)current : next_queue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->lock);
+            queues[index]->tasks.push_back(std::move(t));
+        }
+        {
+            std::lock_guard<std::mutex> lock(idle_lock);
+            queued++;
+        }
+        idle.notify_one();
+    }
+
+  private:
+    struct queue {
+        std::mutex lock;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> next_queue{ 0 };
+
+    std::mutex idle_lock;
+    std::condition_variable idle;
+    size_t queued = 0;
+    bool stopping = false;
+
+    static thread_local int current;
+
+    bool take(size_t index, bool steal, task& out)
+    {
+        auto& q = *queues[index];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (q.tasks.empty()) {
+            return false;
+        }
+
+        if (steal) {
+            out = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            out = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        return true;
+    }
+
+    bool next(size_t self, task& out)
+    {
+        if (take(self, false, out)) {
+            return true;
+        }
+        for (size_t i = 1; i < queues.size(); ++i) {
+            if (take((self + i) % queues.size(), true, out)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t self)
+    {
+        current = (int)self;
+        while (true) {
+            task t;
+            if (next(self, t)) {
+                {
+                    std::lock_guard<std::mutex> lock(idle_lock);
+                    queued--;
+                }
+                t();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(idle_lock);
+            idle.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && !queued) {
+                return;
+            }
+        }
+    }
+};
+
+thread_local int work_pool::current = -1;
+
+enum class sample_format { f32, cu8 };
+
+size_t sample_size(sample_format format)
+{
+    return format == sample_format::f32 ? sizeof(float) : 2;
+}
+
+struct stream {
+    stream(
+      unsigned index_,
+      const std::string& name_,
+      sample_format format_,
+      double tolerance_,
+      double threshold_) :
+        index(index_),
+        name(name_),
+        format(format_),
+        tolerance(tolerance_),
+        threshold(threshold_)
+    {
+        restart();
+    }
+
+    /* Decode the next writer's samples from sample zero. */
+    void restart()
+    {
+        decoder.reset(new ook::stream_decoder(tolerance, threshold));
+    }
+
+    const unsigned index;
+    const std::string name;
+    const sample_format format;
+    const double tolerance;
+    const double threshold;
+    int fd = -1;
+    bool pollable = false;
+    bool fifo = false;
+
+    std::unique_ptr<ook::stream_decoder> decoder;
+    /* Input not yet decoded; less than one sample between reads. */
+    std::vector<uint8_t> bytes;
+    std::vector<float> samples;
+};
+
+std::string json_string(const std::string& s)
+{
+    std::string result = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += (char)c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        } else {
+            result += (char)c;
+        }
+    }
+    return result + "\"";
+}
+
+/* Serialises packets and writes each batch to stdout in one piece. */
+class packet_output
+{
+  public:
+    explicit packet_output(bool binary_) : binary(binary_) {}
+
+    void write(const stream& s, const std::vector<ook::packet>& packets)
+    {
+        if (packets.empty()) {
+            return;
+        }
+
+        std::string out;
+        for (auto& p : packets) {
+            if (binary) {
+                append_binary(out, s, p);
+            } else {
+                append_json(out, s, p);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(write_lock);
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+
+  private:
+    const bool binary;
+    std::mutex write_lock;
+
+    static void append_json(
+      std::string& out,
+      const stream& s,
+      const ook::packet& p)
+    {
+        std::ostringstream os;
+        os << "{\"stream\": " << json_string(s.name) << ", \"data\": \"";
+        for (auto c : p.data) {
+            char hex[3];
+            snprintf(hex, sizeof(hex), "%02x", c);
+            os << hex;
+        }
+        os << "\", \"bit_count\": " << p.bit_count
+           << ", \"sync_count\": " << p.sync_count
+           << ", \"sync_width\": " << p.sync_width
+           << ", \"valid_check\": " << (p.valid_check ? "true" : "false")
+           << ", \"start_sample\": " << p.start_sample
+           << ", \"end_sample\": " << p.end_sample
+           << ", \"pretty\": " << json_string(p.pretty) << "}\n";
+        out += os.str();
+    }
+
+    static void append_binary(
+      std::string& out,
+      const stream& s,
+      const ook::packet& p)
+    {
+        /* The reader caps packets at 1025 bits, well inside a record. */
+        const size_t payload_size = p.data.size();
+
+        uint32_t prefix[2] = { s.index, 0 };
+        ook::packet_log_record record{};
+        record.sample_offset = p.start_sample;
+        record.bit_count = (uint32_t)p.bit_count;
+        record.sync_count = (uint16_t)p.sync_count;
+        record.valid_check = p.valid_check;
+        record.payload_size = (uint16_t)payload_size;
+        record.record_size =
+          (uint16_t)((sizeof(record) + payload_size + 7) & ~(size_t)7);
+
+        out.append((const char*)prefix, sizeof(prefix));
+        out.append((const char*)&record, sizeof(record));
+        out.append((const char*)p.data.data(), payload_size);
+        out.append(record.record_size - sizeof(record) - payload_size, '\0');
+    }
+};
+
+/*
+ * Open a stream's input without blocking. A named pipe without a writer
+ * is not reported readable until one connects.
+ */
+void open_input(stream& s)
+{
+    if (s.name == "-") {
+        s.fd = dup(STDIN_FILENO);
+    } else {
+        s.fd = open(s.name.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    }
+    if (s.fd < 0) {
+        throw std::runtime_error(
+          "cannot open " + s.name + ": " + strerror(errno));
+    }
+    fcntl(s.fd, F_SETFL, fcntl(s.fd, F_GETFL) | O_NONBLOCK);
+
+    struct stat st;
+    s.fifo = s.name != "-" && fstat(s.fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+class decode_daemon
+{
+  public:
+    decode_daemon(unsigned threads, bool binary, bool exit_at_eof_) :
+        epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+        done_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+        exit_at_eof(exit_at_eof_),
+        output(binary),
+        pool(threads)
+    {
+        if (epoll_fd < 0 || done_fd < 0) {
+            throw std::runtime_error(
+              std::string("cannot create epoll: ") + strerror(errno));
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, done_fd, &ev);
+    }
+
+    ~decode_daemon()
+    {
+        /* No task may touch the descriptors once they are closed. */
+        pool.stop();
+        close(done_fd);
+        close(epoll_fd);
+    }
+
+    void add(std::unique_ptr<stream> s)
+    {
+        watch(s.get());
+        open_streams++;
+        stream* raw = s.get();
+        streams.push_back(std::move(s));
+        if (!raw->pollable) {
+            pool.submit([this, raw] { service(raw); });
+        }
+    }
+
+    /* Dispatch readable streams until all have ended or a signal. */
+    void run()
+    {
+        epoll_event events[64];
+        while (open_streams && !stop_requested) {
+            int n = epoll_wait(epoll_fd, events, 64, -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(
+                  std::string("epoll_wait: ") + strerror(errno));
+            }
+
+            for (int i = 0; i < n; ++i) {
+                auto s = (stream*)events[i].data.ptr;
+                if (!s) {
+                    uint64_t count;
+                    (void)read(done_fd, &count, sizeof(count));
+                    continue;
+                }
+                pool.submit([this, s] { service(s); });
+            }
+        }
+    }
+
+  private:
+    int epoll_fd;
+    int done_fd;
+    const bool exit_at_eof;
+    packet_output output;
+    std::vector<std::unique_ptr<stream>> streams;
+    std::atomic<unsigned> open_streams{ 0 };
+    work_pool pool;
+
+    void watch(stream* s)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = s;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s->fd, &ev) == 0) {
+            s->pollable = true;
+        } else if (errno != EPERM) {
+            throw std::runtime_error(
+              "cannot watch " + s->name + ": " + strerror(errno));
+        }
+    }
+
+    /* Decode every whole sample in the stream's buffer. */
+    void decode(stream& s)
+    {
+        const uint8_t* in = s.bytes.data();
+        const size_t width = sample_size(s.format);
+        const size_t n = s.bytes.size() / width;
+
+        s.samples.resize(n);
+        if (s.format == sample_format::f32) {
+            memcpy(s.samples.data(), in, n * sizeof(float));
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                float re = (in[2 * i] - 127.5f) / 127.5f;
+                float im = (in[2 * i + 1] - 127.5f) / 127.5f;
+                s.samples[i] = std::sqrt(re * re + im * im);
+            }
+        }
+        s.bytes.erase(s.bytes.begin(), s.bytes.begin() + n * width);
+
+        output.write(s, s.decoder->feed(s.samples.data(), n));
+    }
+
+    void service(stream* s)
+    {
+        size_t taken = 0;
+        while (taken < max_batch) {
+            if (stop_requested) {
+                return;
+            }
+
+            const size_t kept = s->bytes.size();
+            s->bytes.resize(kept + read_size);
+            ssize_t count = read(s->fd, s->bytes.data() + kept, read_size);
+            s->bytes.resize(kept + std::max<ssize_t>(count, 0));
+            if (count > 0) {
+                decode(*s);
+                taken += count;
+                continue;
+            }
+
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                rearm(s);
+                return;
+            }
+            if (count < 0) {
+                fprintf(
+                  stderr,
+                  "ook_decoded: %s: %s\n",
+                  s->name.c_str(),
+                  strerror(errno));
+            }
+
+            finish(s);
+            return;
+        }
+
+        /* Let the other streams have a turn. */
+        pool.submit([this, s] { service(s); });
+    }
+
+    void rearm(stream* s)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = s;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s->fd, &ev);
+    }
+
+    void finish(stream* s)
+    {
+        output.write(*s, s->decoder->flush());
+        s->bytes.clear();
+        if (s->pollable) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, nullptr);
+        }
+        close(s->fd);
+        s->fd = -1;
+
+        if (s->fifo && !exit_at_eof) {
+            try {
+                s->restart();
+                open_input(*s);
+                watch(s);
+                return;
+            } catch (const std::exception& ex) {
+                fprintf(stderr, "ook_decoded: %s\n", ex.what());
+            }
+        }
+
+        if (--open_streams == 0) {
+            uint64_t one = 1;
+            (void)write(done_fd, &one, sizeof(one));
+        }
+    }
+};
+
+void usage(const char* argv0)
+{
+    fprintf(
+      stderr,
+      "usage: %s [options] [FORMAT:]INPUT...\n"
+      "\n"
+      "Decode OOK packets from sample streams. INPUT is a named pipe,\n"
+      "a file or '-' for stdin. FORMAT is f32 (float envelope, the\n"
+      "default) or cu8 (interleaved unsigned 8-bit I/Q).\n"
+      "\n"
+      "  -j THREADS     decoder threads (default: number of CPUs)\n"
+      "  -t TOLERANCE   pulse width tolerance (default 0.1)\n"
+      "  -T THRESHOLD   slicing threshold (default 0.5)\n"
+      "  -b             write binary records instead of JSON lines\n"
+      "  -x             exit once every input has ended; named pipes\n"
+      "                 are otherwise reopened for the next writer\n",
+      argv0);
+}
+
+std::unique_ptr<stream> make_stream(
+  unsigned index,
+  std::string spec,
+  double tolerance,
+  double threshold)
+{
+    sample_format format = sample_format::f32;
+    if (spec.compare(0, 4, "f32:") == 0) {
+        spec = spec.substr(4);
+    } else if (spec.compare(0, 4, "cu8:") == 0) {
+        format = sample_format::cu8;
+        spec = spec.substr(4);
+    }
+
+    std::unique_ptr<stream> s(
+      new stream(index, spec, format, tolerance, threshold));
+    open_input(*s);
+    return s;
+}
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    double tolerance = 0.1;
+    double threshold = 0.5;
+    bool binary = false;
+    bool exit_at_eof = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:t:T:bxh")) != -1) {
+        switch (opt) {
+        case 'j':
+            threads = std::max(1, atoi(optarg));
+            break;
+        case 't':
+            tolerance = atof(optarg);
+            break;
+        case 'T':
+            threshold = atof(optarg);
+            break;
+        case 'b':
+            binary = true;
+            break;
+        case 'x':
+            exit_at_eof = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (optind == argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    struct sigaction action{};
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    try {
+        decode_daemon d(threads, binary, exit_at_eof);
+        for (int i = optind; i < argc; ++i) {
+            d.add(make_stream(i - optind, argv[i], tolerance, threshold));
+        }
+        d.run();
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "ook_decoded: %s\n", ex.what());
+        return 1;
+    }
+
+    return 0;
+}
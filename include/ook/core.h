@@ -0,0 +1,218 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_CORE_H
+#define INCLUDED_OOK_CORE_H
+
+#include <ook/packet.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * The ook-core library: the decoder and transmitter behind the GNU Radio
+ * blocks, with a plain push API. It depends on nothing but the C++
+ * standard library, so it can be built into programs without a
+ * flowgraph.
+ */
+namespace gr
+{
+namespace ook
+{
+namespace core
+{
+/*!
+ * \brief A decoded packet, as passed to a decoder's callback.
+ *
+ * The fields are those of ook::packet. The pointers refer to storage
+ * owned by the decoder and are only valid during the callback; use
+ * to_packet() to keep a copy.
+ */
+struct packet_info {
+    const std::uint8_t* data;
+    size_t size;
+    size_t bit_count;
+    int sync_count;
+    int sync_width;
+    double sync_width_us;
+    bool valid_check;
+    std::uint64_t start_sample;
+    std::uint64_t end_sample;
+    bool has_levels;
+    double rssi;
+    double noise;
+    double snr;
+    const char* pretty;
+    const char* phy_pretty;
+};
+
+/*! Copy a packet_info into an ook::packet. */
+packet to_packet(const packet_info& info);
+
+/*!
+ * \brief Decoder settings that may change while decoding.
+ *
+ * See ook::decode for their meaning. The threshold is a fraction of full
+ * scale whatever the sample type.
+ */
+struct decoder_settings {
+    double tolerance = 0.1;
+    double threshold = 0.5;
+    double min_width_us = 0;
+    double max_width_us = 0;
+    int min_sync_count = 0;
+    std::vector<int> expected_bits;
+    bool learn_lengths = false;
+    bool verbose = false;
+};
+
+/*! \brief Everything a decoder is constructed with. */
+struct decoder_config {
+    decoder_settings settings;
+    double sample_rate = 0;
+    bool levels = false;
+    bool interpolate = false;
+    double squelch = 0;
+    std::string record_prefix;
+    int record_ring = 1 << 20;
+    int record_files = 8;
+    double record_kb_per_s = 1024;
+    double sync_correlation = 0;
+};
+
+/*!
+ * \brief Decodes OOK packets from an envelope pushed by the caller.
+ *
+ * T is the sample type: float, or int16_t/int8_t with full scale at
+ * their maximum. State carries over between calls to feed(), so the
+ * input may be passed in arbitrary pieces. The callback runs on the
+ * thread that calls feed() or flush(), once per packet, in order.
+ */
+template <class T>
+class basic_decoder
+{
+  public:
+    typedef std::function<void(const packet_info&)> callback;
+
+    basic_decoder(const decoder_config& config, callback on_packet);
+    ~basic_decoder();
+
+    basic_decoder(const basic_decoder&) = delete;
+    basic_decoder& operator=(const basic_decoder&) = delete;
+
+    /*! Decode 'count' samples. */
+    void feed(const T* samples, size_t count);
+
+    /*!
+     * Finish the packet in progress, if any, as if the input had gone
+     * quiet, and wait for the flight recorder. Use at the end of a
+     * stream, or before a gap in it: input fed afterwards continues at
+     * the sample position where this input ended.
+     */
+    void flush();
+
+    /*!
+     * Switch to new settings. They take effect between packets, so the
+     * packet in progress is decoded with the old ones.
+     */
+    void update(const decoder_settings& settings);
+
+    /*!
+     * Trade sensitivity for speed while the caller cannot keep up; see
+     * the max_load parameter of ook::decode.
+     */
+    void set_degraded(bool degraded);
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+typedef basic_decoder<float> decoder;
+
+/*!
+ * \brief A packet boundary in a transmitter's output.
+ *
+ * 'offset' is the index of the packet's first (start) or last sample in
+ * the buffer passed to transmitter::generate(). 'context' is the pointer
+ * held by the owner given to transmitter::enqueue().
+ */
+struct transmission {
+    int offset;
+    bool start;
+    std::uint64_t seq;
+    const std::uint8_t* data;
+    size_t size;
+    const void* context;
+};
+
+/*!
+ * \brief Generates the envelope of queued packets.
+ *
+ * Packets go out in the order they were queued, each preceded by 10 ms
+ * of silence and followed by 'ms_between_xmit' ms of it, with silence
+ * while the queue is empty. The transmitter stops after 'stop_after'
+ * packets, or never if that is negative. Packets may be queued from any
+ * thread.
+ */
+class transmitter
+{
+  public:
+    typedef std::function<void(const transmission&)> callback;
+
+    transmitter(int stop_after, int ms_between_xmit, int sample_rate);
+    ~transmitter();
+
+    transmitter(const transmitter&) = delete;
+    transmitter& operator=(const transmitter&) = delete;
+
+    /*!
+     * Queue 'size' bytes at 'data', which must stay valid until they
+     * are sent; 'owner' is released once they have been.
+     */
+    void enqueue(
+      const std::uint8_t* data,
+      size_t size,
+      std::shared_ptr<const void> owner = nullptr);
+
+    /*! Queue a copy of 'data'. */
+    void enqueue(const std::vector<std::uint8_t>& data);
+
+    /*!
+     * Write up to 'n' samples to 'out' and return how many were written,
+     * or zero once the transmitter has stopped. The boundaries of the
+     * packets in the output are reported through 'on_boundary' before
+     * generate() returns.
+     */
+    int generate(float* out, int n, const callback& on_boundary = nullptr);
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+} // namespace core
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_CORE_H */
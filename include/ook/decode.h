@@ -23,20 +23,53 @@
 
 #include <ook/api.h>
 #include <gnuradio/block.h>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace gr
 {
 namespace ook
 {
 /*!
- * \brief <+description of block+>
+ * \brief Decode OOK packets from an envelope stream.
  * \ingroup ook
  *
+ * The block is templated on the input sample type. ook::decode takes
+ * float envelopes, while ook::decode_s and ook::decode_b take int16 and
+ * int8 envelopes scaled to the full range of the type. Fixed-point
+ * inputs are sliced against an integer threshold, so slicing never
+ * converts samples to float. The sync correlator and the flight
+ * recorder do work on float copies of the samples they look at.
+ *
+ * With a sample rate and a maximum load, the block compares the time it
+ * spends in each work call with the duration of the samples. When it
+ * misses a deadline, or its load over a tenth of a second of input goes
+ * above the maximum, it falls back to a cheaper mode until the load has
+ * dropped below half the maximum. In that mode packets have empty
+ * 'pretty' and 'phy_pretty' strings, debug output is off, sync trains
+ * need wider pulses and more of them, and quiet input is only sampled
+ * sparsely. Each change of mode is published on the 'overload' port as a
+ * dict with 'overloaded', the last 'load', the total 'missed_deadlines'
+ * and the 'sample' at which the work call that changed mode started.
+ *
+ * The tolerance, threshold, pulse limits, expected lengths and debug
+ * output can be changed while the flowgraph runs, with the setters or by
+ * sending a dict to the 'config' port. A dict may hold any of the keys
+ * 'tolerance', 'threshold', 'min_width_us', 'max_width_us',
+ * 'min_sync_count', 'expected_bits' (a vector of lengths),
+ * 'learn_lengths' and 'verbose'; a dict with an unknown key or a value
+ * of the wrong type is rejected as a whole. Changes are held until the
+ * decoder is between packets and then applied together, so a packet is
+ * never decoded with a mix of old and new settings and no packet in
+ * progress is dropped. That includes the threshold: the slicer and the
+ * sync correlator only switch to a new one when the rest is applied.
  */
-class OOK_API decode : virtual public gr::block
+template <class T>
+class OOK_API decode_blk : virtual public gr::block
 {
   public:
-    typedef boost::shared_ptr<decode> sptr;
+    typedef boost::shared_ptr<decode_blk<T>> sptr;
 
     /*!
      * \brief Return a shared_ptr to a new instance of ook::decode.
@@ -45,10 +78,136 @@ class OOK_API decode : virtual public gr::block
      * constructor is in a private implementation
      * class. ook::decode::make is the public interface for
      * creating new instances.
+     *
+     * \param tolerance relative tolerance applied to pulse widths.
+     * \param threshold slicing level as a fraction of full scale. For
+     *        integer sample types this is converted to an integer
+     *        threshold, again whenever set_threshold() or the 'config'
+     *        port changes it.
+     * \param timestamps add 'sample_time' and 'publish_time' to each
+     *        published packet.
+     * \param expected_bits data lengths, in bits, for which a packet is
+     *        published as soon as the last bit of its check copy arrives
+     *        rather than after the trailing silence.
+     * \param learn_lengths also treat the lengths of recent valid packets
+     *        as expected.
+     * \param sample_rate input sample rate in Hz, or 0 if unknown. It
+     *        enables the pulse width limits and 'sync_width_us'.
+     * \param min_width_us narrowest plausible sync pulse (0: no limit).
+     * \param max_width_us widest plausible sync pulse (0: no limit).
+     * \param min_sync_count fewest sync pulses accepted before the
+     *        preamble.
+     * \param batch_size publish packets as PMT vectors of up to this
+     *        many packets on the 'packets' port instead of one message
+     *        each on 'packet'. 0 disables batching.
+     * \param batch_timeout_ms publish a partial batch once its oldest
+     *        packet has waited this long. It is only checked when
+     *        samples arrive, so if the input stalls a partial batch
+     *        waits for more input or for the flowgraph to stop. 0
+     *        publishes every work call's packets together.
+     * \param max_load fraction of real time the block may spend working
+     *        before it switches to a degraded mode, which needs the
+     *        sample rate. 0 disables overload detection.
+     * \param levels measure each packet's 'rssi', 'noise' and 'snr'
+     *        (see ook::packet) while slicing.
+     * \param interpolate time each edge by where the envelope crosses
+     *        the threshold between two samples, and classify bits on the
+     *        fractional pulse widths. This keeps the decoder accurate at
+     *        a few samples per bit, rather than needing heavy
+     *        oversampling. Positions are then late by half a sample.
+     * \param squelch RMS level, as a fraction of full scale, below which
+     *        the input is taken as idle. The power is measured over
+     *        blocks of 64 samples; idle spans are passed to the decoder
+     *        as a single low run each, so noise between packets costs
+     *        neither slicing nor sync attempts. The last 128 samples
+     *        before the squelch opens are still decoded in full, and it
+     *        closes once the power has stayed 3 dB below the level for
+     *        256 samples. 0 disables the squelch.
+     * \param record_prefix path prefix for a flight recorder of failed
+     *        decodes, or empty to disable it. The block keeps the last
+     *        'record_ring' samples in memory. Whenever an attempt with a
+     *        detected sync train fails, the samples from shortly before
+     *        the sync train to the failure are written by a background
+     *        thread to '<prefix>.<n>.f32', with the reason and positions
+     *        in '<prefix>.<n>.json'. n cycles through 'record_files'
+     *        slots.
+     * \param record_ring size of the flight recorder's ring, in samples.
+     * \param record_files number of windows kept on disk.
+     * \param record_kb_per_s I/O budget of the flight recorder in KiB of
+     *        samples per second. Windows beyond it are dropped rather
+     *        than delaying the decoder.
+     * \param sync_correlation find sync trains with a matched filter
+     *        instead of pulse by pulse, and only start decoding where
+     *        one is found. The envelope is correlated, by FFT, with
+     *        templates of eight sync periods for pulse widths from
+     *        min_width_us to max_width_us, which both need setting along
+     *        with the sample rate. A sync train is taken where the
+     *        normalized correlation reaches this score (1 for a clean
+     *        train; around 0.5 works well), after which its pulses only
+     *        have to roughly follow the width up to the preamble. This
+     *        finds packets whose sync trains are broken up by noise, but
+     *        delays decoding by up to four template lengths. 0 disables
+     *        it.
+     */
+    static sptr make(
+      double tolerance = 0.1,
+      double threshold = 0.5,
+      bool timestamps = false,
+      const std::vector<int>& expected_bits = std::vector<int>(),
+      bool learn_lengths = false,
+      double sample_rate = 0,
+      double min_width_us = 0,
+      double max_width_us = 0,
+      int min_sync_count = 0,
+      int batch_size = 0,
+      double batch_timeout_ms = 0,
+      double max_load = 0,
+      bool levels = false,
+      bool interpolate = false,
+      double squelch = 0,
+      const std::string& record_prefix = "",
+      int record_ring = 1 << 20,
+      int record_files = 8,
+      double record_kb_per_s = 1024,
+      double sync_correlation = 0);
+
+    /*!
+     * \brief Histogram of the time from the arrival of a packet's last
+     * sample to its publication.
+     *
+     * Bucket 0 counts latencies under 1us and bucket i counts latencies
+     * in [2^(i-1), 2^i) us; the last bucket also counts anything longer.
+     */
+    virtual std::vector<std::uint64_t> latency_histogram() const = 0;
+
+    virtual void set_tolerance(double tolerance) = 0;
+    virtual void set_threshold(double threshold) = 0;
+
+    /*!
+     * \brief Change the pulse limits; the sample rate stays as given to
+     * make. With sync_correlation, the correlator keeps searching the
+     * width range it was made with.
+     */
+    virtual void set_limits(
+      double min_width_us,
+      double max_width_us,
+      int min_sync_count) = 0;
+
+    virtual void set_expected_bits(
+      const std::vector<int>& expected_bits,
+      bool learn_lengths) = 0;
+
+    /*!
+     * \brief Print this block's decode debug output, as if
+     * OOK_DECODE_DEBUG were set for it alone.
      */
-    static sptr make(double tolerance = 0.1);
+    virtual void set_verbose(bool verbose) = 0;
 };
 
+typedef decode_blk<float> decode;
+typedef decode_blk<std::int16_t> decode_s;
+typedef decode_blk<std::int8_t> decode_b;
+
 } // namespace ook
 } // namespace gr
 
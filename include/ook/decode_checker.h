@@ -0,0 +1,83 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_OOK_DECODE_CHECKER_H
+#define INCLUDED_OOK_DECODE_CHECKER_H
+
+#include <ook/api.h>
+#include <gnuradio/sync_block.h>
+#include <cstdint>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Score a decoder against the transmissions of a packet_source.
+ * \ingroup ook
+ *
+ * The input is the envelope the decoder sees, or any stream that
+ * carries the 'packet_start' and 'packet_end' tags of an
+ * ook::packet_source; only the tags are read. Decoded packets, or
+ * batches of them, arrive on the 'packet' port.
+ *
+ * A packet is a detection when a transmission that has not already
+ * been detected has the same payload and overlaps the samples from the
+ * packet's start_sample to its end_sample. Its latency is the number of
+ * samples from the last sample of the transmission to end_sample. Any
+ * other packet, once the tags up to its end_sample have arrived, is a
+ * false positive; that includes corrupted and duplicate packets.
+ *
+ * Each verdict is published on 'result' as a dict with the decoded
+ * 'packet' and a 'status' of 'detected' or 'false_positive'. Detections
+ * also carry the transmission's 'seq' and the 'latency'.
+ */
+class OOK_API decode_checker : virtual public gr::sync_block
+{
+  public:
+    typedef boost::shared_ptr<decode_checker> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::decode_checker.
+     */
+    static sptr make();
+
+    /*! Number of transmissions started so far. */
+    virtual std::uint64_t transmitted() const = 0;
+
+    /*! Number of transmissions detected. */
+    virtual std::uint64_t detected() const = 0;
+
+    /*! Number of packets that matched no transmission. */
+    virtual std::uint64_t false_positives() const = 0;
+
+    /*! Fraction of the transmissions detected, or 0 before the first. */
+    virtual double detection_rate() const = 0;
+
+    /*! Latency of each detection in samples, in the order detected. */
+    virtual std::vector<std::uint64_t> latencies() const = 0;
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_DECODE_CHECKER_H */
@@ -0,0 +1,59 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_EDGE_DETECTOR_H
+#define INCLUDED_OOK_EDGE_DETECTOR_H
+
+#include <ook/api.h>
+#include <gnuradio/block.h>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Slice a float envelope into a stream of runs.
+ * \ingroup ook
+ *
+ * Each output item is one run (see ook/run.h): its magnitude is the
+ * duration in samples and its sign the level. The run in progress at the
+ * end of each work call is flushed, so downstream blocks see long runs
+ * in pieces rather than waiting for the next edge.
+ *
+ * Pair with ook::run_decoder to run slicing and protocol decoding on
+ * separate threads.
+ */
+class OOK_API edge_detector : virtual public gr::block
+{
+  public:
+    typedef boost::shared_ptr<edge_detector> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::edge_detector.
+     *
+     * \param threshold slicing level for the input envelope.
+     */
+    static sptr make(double threshold = 0.5);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_EDGE_DETECTOR_H */
@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_MODULATOR_H
+#define INCLUDED_OOK_MODULATOR_H
+
+#include <ook/api.h>
+#include <gnuradio/tagged_stream_block.h>
+#include <string>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Generate the OOK envelope for a tagged stream of packets.
+ * \ingroup ook
+ *
+ * Each tagged input packet of bytes becomes one transmission with the
+ * same format as ook::packet_source produces, followed by \p gap_ms of
+ * silence. The output is tagged with the length of each transmission,
+ * so it can feed burst-mode sinks directly.
+ */
+class OOK_API modulator : virtual public gr::tagged_stream_block
+{
+  public:
+    typedef boost::shared_ptr<modulator> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::modulator.
+     *
+     * \param sample_rate output sample rate.
+     * \param gap_ms silence appended after each transmission.
+     * \param len_tag_key key of the packet length tags.
+     */
+    static sptr make(
+      int sample_rate = 32000,
+      int gap_ms = 10,
+      const std::string& len_tag_key = "packet_len");
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_MODULATOR_H */
@@ -0,0 +1,82 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_MULTI_DECODE_H
+#define INCLUDED_OOK_MULTI_DECODE_H
+
+#include <ook/api.h>
+#include <gnuradio/block.h>
+#include <cstdint>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Decode OOK packets from several interleaved envelope streams.
+ * \ingroup ook
+ *
+ * The input is a single float stream with a vector length of
+ * 'channels', holding one sample per channel in each item, as produced
+ * by a channelizer or blocks.streams_to_vector. All channels are sliced
+ * in one pass over the input, several channels per SIMD instruction,
+ * and each channel then has its own protocol state machine. Packets are
+ * published as by ook::decode with an extra 'channel' entry; their
+ * sample positions count items, i.e. samples of their own channel.
+ */
+class OOK_API multi_decode : virtual public gr::block
+{
+  public:
+    typedef boost::shared_ptr<multi_decode> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::multi_decode.
+     *
+     * \param channels the number of interleaved channels.
+     *
+     * The remaining parameters apply to every channel and are as for
+     * ook::decode.
+     */
+    static sptr make(
+      int channels,
+      double tolerance = 0.1,
+      double threshold = 0.5,
+      bool timestamps = false,
+      const std::vector<int>& expected_bits = std::vector<int>(),
+      bool learn_lengths = false,
+      double sample_rate = 0,
+      double min_width_us = 0,
+      double max_width_us = 0,
+      int min_sync_count = 0,
+      int batch_size = 0,
+      double batch_timeout_ms = 0);
+
+    /*!
+     * \brief Histogram of publication latencies across all channels, as
+     * for ook::decode.
+     */
+    virtual std::vector<std::uint64_t> latency_histogram() const = 0;
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_MULTI_DECODE_H */
@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_H
+#define INCLUDED_OOK_PACKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief A decoded OOK packet.
+ * \ingroup ook
+ *
+ * The blocks publish this as a PMT dictionary with the same keys. When
+ * timestamps are enabled on a block, the dictionary also carries
+ * 'sample_time' and 'publish_time': the wall-clock time (seconds since
+ * the epoch) at which the block received end_sample and at which it
+ * published the packet.
+ */
+struct packet {
+    /*! Data bits, MSB first, zero padded to a whole byte. */
+    std::vector<std::uint8_t> data;
+    /*! Number of data bits received. */
+    size_t bit_count = 0;
+    /*! Number of sync pulses seen before the preamble. */
+    int sync_count = 0;
+    /*! Detected sync pulse width, in samples. */
+    int sync_width = 0;
+    /*!
+     * Detected sync pulse width in microseconds, or zero if the decoder
+     * was not given a sample rate. Only published when non-zero.
+     */
+    double sync_width_us = 0;
+    /*! Whether the check copy matched the data. */
+    bool valid_check = false;
+    /*! Absolute index of the first sample of the sync train. */
+    std::uint64_t start_sample = 0;
+    /*!
+     * Absolute index of the sample that completed the packet, i.e. the
+     * last sample the decoder needed before it could publish it.
+     */
+    std::uint64_t end_sample = 0;
+    /*!
+     * Whether the signal level fields below were measured. Only blocks
+     * that see the envelope can measure them, and only if asked to;
+     * the fields are only published when set.
+     */
+    bool has_levels = false;
+    /*! Mean envelope of the packet's high samples, as for the threshold. */
+    double rssi = 0;
+    /*! Mean envelope of the packet's low samples. */
+    double noise = 0;
+    /*!
+     * The separation of the two levels against the spread of the samples
+     * around them, in dB: 10 log10((rssi - noise)^2 / variance). Capped
+     * at 120 dB for noiseless input.
+     */
+    double snr = 0;
+    /*! One-line summary of the packet. */
+    std::string pretty;
+    /*! Bit-level comparison of the data and check copies. */
+    std::string phy_pretty;
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_H */
@@ -0,0 +1,153 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_LOG_H
+#define INCLUDED_OOK_PACKET_LOG_H
+
+#include <ook/api.h>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Header at the start of every packet log segment.
+ * \ingroup ook
+ *
+ * A segment is a header followed by \p used bytes of records. All fields
+ * are little-endian. The writer updates \p used and \p count after each
+ * record, so a segment that is still being written can be read up to
+ * the last complete record.
+ */
+struct packet_log_header {
+    char magic[8];              /*!< "OOKLOG\0\0" */
+    std::uint32_t version;      /*!< format version, currently 1 */
+    std::uint32_t header_size;  /*!< offset of the first record */
+    std::uint64_t used;         /*!< bytes of records after the header */
+    std::uint64_t count;        /*!< number of records */
+};
+
+/*!
+ * \brief One packet in a packet log segment.
+ * \ingroup ook
+ *
+ * The payload follows the fixed fields directly. Records are padded to
+ * a multiple of 8 bytes; \p record_size is the padded size.
+ */
+struct packet_log_record {
+    std::uint64_t sample_offset; /*!< absolute index of the first sample */
+    std::uint32_t bit_count;     /*!< data bits received */
+    std::uint16_t sync_count;    /*!< sync pulses before the preamble */
+    std::uint8_t valid_check;    /*!< 1 if the check copy matched */
+    std::uint8_t reserved0;
+    std::uint16_t payload_size;  /*!< payload bytes */
+    std::uint16_t record_size;   /*!< total size including padding */
+    std::uint32_t reserved1;
+
+    const std::uint8_t* payload() const
+    {
+        return reinterpret_cast<const std::uint8_t*>(this + 1);
+    }
+};
+
+static_assert(sizeof(packet_log_header) == 32, "packet_log_header layout");
+static_assert(sizeof(packet_log_record) == 24, "packet_log_record layout");
+
+/*!
+ * \brief Read-only, memory-mapped view of one packet log segment.
+ * \ingroup ook
+ *
+ * Iterating yields references to records inside the mapping; nothing is
+ * copied. The view covers the records present when it was opened.
+ */
+class OOK_API packet_log_reader
+{
+  public:
+    class iterator
+    {
+      private:
+        const char* pos;
+
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef packet_log_record value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const packet_log_record* pointer;
+        typedef const packet_log_record& reference;
+
+        explicit iterator(const char* p) : pos(p) {}
+
+        reference operator*() const
+        {
+            return *reinterpret_cast<pointer>(pos);
+        }
+        pointer operator->() const
+        {
+            return reinterpret_cast<pointer>(pos);
+        }
+        iterator& operator++()
+        {
+            pos += (**this).record_size;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator result = *this;
+            ++*this;
+            return result;
+        }
+        bool operator==(const iterator& other) const
+        {
+            return pos == other.pos;
+        }
+        bool operator!=(const iterator& other) const
+        {
+            return pos != other.pos;
+        }
+    };
+
+    /*! Map the segment at \p path. Throws std::runtime_error on failure. */
+    explicit packet_log_reader(const std::string& path);
+    ~packet_log_reader();
+
+    packet_log_reader(const packet_log_reader&) = delete;
+    packet_log_reader& operator=(const packet_log_reader&) = delete;
+
+    iterator begin() const;
+    iterator end() const;
+
+    /*! Number of records in the segment. */
+    std::uint64_t size() const;
+
+  private:
+    const char* map_ = nullptr;
+    size_t length_ = 0;
+    std::uint64_t used_ = 0;
+    std::uint64_t count_ = 0;
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_LOG_H */
@@ -0,0 +1,60 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_LOG_SINK_H
+#define INCLUDED_OOK_PACKET_LOG_SINK_H
+
+#include <ook/api.h>
+#include <gnuradio/block.h>
+#include <string>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Record decoded packets to memory-mapped binary log segments.
+ * \ingroup ook
+ *
+ * Packets arriving on the 'packet' message port, singly or as the
+ * batches the decoders publish on 'packets', are appended to files
+ * named '<prefix>.<index>.ooklog' in the format described by
+ * ook/packet_log.h. A new segment is started whenever the current one
+ * fills up; existing files are never overwritten. Read the segments back
+ * with ook::packet_log_reader or the ook.packet_log Python module.
+ */
+class OOK_API packet_log_sink : virtual public gr::block
+{
+  public:
+    typedef boost::shared_ptr<packet_log_sink> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::packet_log_sink.
+     *
+     * \param prefix path prefix for the segment files.
+     * \param segment_mb size of each segment in MiB.
+     */
+    static sptr make(const std::string& prefix, int segment_mb = 64);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_LOG_SINK_H */
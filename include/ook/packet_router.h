@@ -0,0 +1,74 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_ROUTER_H
+#define INCLUDED_OOK_PACKET_ROUTER_H
+
+#include <ook/api.h>
+#include <gnuradio/block.h>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Route decoded packets to named message ports by payload.
+ * \ingroup ook
+ *
+ * Each rule has the form '<port>=<pattern>', where the pattern is a hex
+ * prefix of the payload. An 'x' or '?' digit matches any nibble, and a
+ * '/<hex mask>' suffix selects individual bits, so '33a0xx8c' and
+ * '33a0008c/ffff00ff' are equivalent. Packets matching a rule are
+ * published on its port; when several rules match, the first one listed
+ * wins. Rules may share a port.
+ *
+ * The rules are compiled into a single automaton, so the cost of routing
+ * a packet depends on its length rather than on the number of rules.
+ *
+ * Packets that fail the filters are dropped. Packets that pass them but
+ * match no rule are published on 'unmatched'. Batches arriving from a
+ * decoder's 'packets' port are routed as batches.
+ */
+class OOK_API packet_router : virtual public gr::block
+{
+  public:
+    typedef boost::shared_ptr<packet_router> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::packet_router.
+     *
+     * \param rules the routing rules, as described above.
+     * \param require_valid drop packets that failed their check.
+     * \param min_bits drop packets with fewer bits than this.
+     * \param max_bits drop packets with more bits than this, if non-zero.
+     */
+    static sptr make(
+      const std::vector<std::string>& rules,
+      bool require_valid = false,
+      int min_bits = 0,
+      int max_bits = 0);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_ROUTER_H */
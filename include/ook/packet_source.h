@@ -24,14 +24,31 @@
 
 #include <ook/api.h>
 #include <gnuradio/sync_block.h>
+#include <cstdint>
+#include <string>
 
 namespace gr {
   namespace ook {
 
     /*!
-     * \brief <+description of block+>
+     * \brief Generate the OOK envelope for a queue of packets.
      * \ingroup ook
      *
+     * Packets are taken from the 'packets' message port, which accepts
+     * u8vectors and standard PDUs (the payload is read in place), as
+     * well as s32vectors of byte values.
+     *
+     * The first and last samples of each transmission carry the stream
+     * tags 'packet_start' and 'packet_end'. Both tags have the same
+     * value: a dict with the payload as 'data' and a sequence number,
+     * counting transmissions from zero, as 'seq'. ook::decode_checker
+     * uses them as the ground truth for the packets a decoder reports.
+     *
+     * Instead of the envelope, the block can write the keyed carrier as
+     * complex baseband, ready for an SDR sink. The carrier is generated
+     * at an offset from the center frequency by a vectorized NCO whose
+     * phase runs on through gaps, so each transmission is a burst of one
+     * continuous tone.
      */
     class OOK_API packet_source : virtual public gr::sync_block
     {
@@ -45,12 +62,24 @@ namespace gr {
        * constructor is in a private implementation
        * class. ook::packet_source::make is the public interface for
        * creating new instances.
+       *
+       * \param format the output items: "float" for the 0/1 envelope,
+       *        "complex" for the carrier as gr_complex, or "sc16" and
+       *        "sc8" for the carrier as interleaved int16 or int8 I/Q
+       *        scaled to the full range of the type.
+       * \param if_offset_hz frequency of the carrier relative to the
+       *        center; it may be negative. Ignored for "float".
+       * \param amplitude peak magnitude of the carrier. The integer
+       *        formats take it as a fraction of full scale, up to 1.
        */
       static sptr make(
-        const std::vector<int> &data,
+        const std::vector<uint8_t> &data,
         int stop_after = 1,
         int ms_between_xmit = 10,
-        int sample_rate = 32000
+        int sample_rate = 32000,
+        const std::string &format = "float",
+        double if_offset_hz = 0,
+        double amplitude = 1.0
       );
     };
 
@@ -0,0 +1,140 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_RL_CAPTURE_H
+#define INCLUDED_OOK_RL_CAPTURE_H
+
+#include <ook/api.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Header at the start of a run-length capture (.ookrl) file.
+ * \ingroup ook
+ *
+ * A capture stores a sliced envelope as its runs rather than its
+ * samples. All fields are little-endian. The header is followed by
+ * \p data_size bytes of runs and then, at \p index_offset, by
+ * \p index_count index entries.
+ *
+ * Each run is a LEB128 varint of (duration << 1 | level), with the
+ * duration in whole samples and the level 1 for high. If
+ * \p amplitude_bits is 8 or 16 the varint is followed by a 1 or 2 byte
+ * code for the run's mean envelope: code / (2^bits - 1) * full_scale,
+ * clamped to [0, full_scale]. Consecutive runs alternate in level.
+ *
+ * The writer fills in the counts and the index when it closes the file.
+ * A capture that was never closed has \p index_offset 0; its runs
+ * extend to the end of the file, less any incomplete last run.
+ */
+struct rl_capture_header {
+    char magic[8];              /*!< "OOKRL\0\0\0" */
+    std::uint32_t version;      /*!< format version, currently 1 */
+    std::uint32_t header_size;  /*!< offset of the first run */
+    double sample_rate;         /*!< Hz, or 0 if unknown */
+    float threshold;            /*!< level the envelope was sliced at */
+    float full_scale;           /*!< envelope of the largest code */
+    std::uint8_t amplitude_bits; /*!< 0, 8 or 16 */
+    std::uint8_t reserved[7];
+    std::uint64_t sample_count; /*!< samples covered by the runs */
+    std::uint64_t run_count;    /*!< number of runs */
+    std::uint64_t data_size;    /*!< bytes of runs after the header */
+    std::uint64_t index_offset; /*!< file offset of the index, or 0 */
+    std::uint64_t index_count;  /*!< number of index entries */
+};
+
+/*!
+ * \brief Entry in the index of a run-length capture.
+ * \ingroup ook
+ *
+ * The writer adds one at the first run to start after every
+ * rl_capture_index_interval samples, so a reader can seek without
+ * decoding the runs before the one it wants.
+ */
+struct rl_capture_index_entry {
+    std::uint64_t sample; /*!< first sample of the run */
+    std::uint64_t offset; /*!< offset of the run from the first run */
+};
+
+static_assert(sizeof(rl_capture_header) == 80, "rl_capture_header layout");
+static_assert(
+  sizeof(rl_capture_index_entry) == 16,
+  "rl_capture_index_entry layout");
+
+/*! \brief Samples between the index entries of a run-length capture. */
+const std::uint64_t rl_capture_index_interval = 1 << 20;
+
+/*! \brief One run read back from a run-length capture. */
+struct rl_capture_run {
+    std::uint64_t start_sample; /*!< index of the run's first sample */
+    std::uint64_t duration;     /*!< in samples */
+    bool level;                 /*!< true for high */
+    float amplitude; /*!< mean envelope, or full_scale/0 without codes */
+};
+
+/*!
+ * \brief Read-only, memory-mapped view of a run-length capture.
+ * \ingroup ook
+ *
+ * Reads runs in order from a position set by seek(). The view covers
+ * the runs present when it was opened.
+ */
+class OOK_API rl_capture_reader
+{
+  public:
+    /*! Map the capture at \p path. Throws std::runtime_error on failure. */
+    explicit rl_capture_reader(const std::string& path);
+    ~rl_capture_reader();
+
+    rl_capture_reader(const rl_capture_reader&) = delete;
+    rl_capture_reader& operator=(const rl_capture_reader&) = delete;
+
+    const rl_capture_header& header() const;
+
+    /*!
+     * Continue from the run that contains \p sample, or from the end if
+     * the capture is shorter. Uses the index where there is one.
+     */
+    void seek(std::uint64_t sample);
+
+    /*! Read the next run into \p run; false at the end of the capture. */
+    bool next(rl_capture_run& run);
+
+  private:
+    const char* map_ = nullptr;
+    size_t length_ = 0;
+    const std::uint8_t* runs_ = nullptr;
+    size_t runs_size_ = 0;
+    const char* index_ = nullptr;
+    size_t index_count_ = 0;
+
+    size_t pos_ = 0;
+    std::uint64_t sample_ = 0;
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RL_CAPTURE_H */
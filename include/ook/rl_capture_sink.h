@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_OOK_RL_CAPTURE_SINK_H
+#define INCLUDED_OOK_RL_CAPTURE_SINK_H
+
+#include <ook/api.h>
+#include <gnuradio/sync_block.h>
+#include <string>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Record a float envelope as a run-length capture.
+ * \ingroup ook
+ *
+ * Slices the envelope and writes its runs to a .ookrl file in the
+ * format described by ook/rl_capture.h, replacing any file at the path.
+ * An OOK capture is mostly long constant runs, so the file is typically
+ * hundreds of times smaller than the raw float samples. Replay it with
+ * ook::rl_capture_source. The file is complete whenever the flowgraph
+ * stops; if it is started again, the new input extends the capture.
+ */
+class OOK_API rl_capture_sink : virtual public gr::sync_block
+{
+  public:
+    typedef boost::shared_ptr<rl_capture_sink> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::rl_capture_sink.
+     *
+     * \param path the file to write.
+     * \param threshold slicing level for the input envelope.
+     * \param sample_rate input sample rate in Hz, or 0 if unknown. It is
+     *        only recorded in the header.
+     * \param amplitude_bits 8 or 16 to also record each run's mean
+     *        envelope, quantised to that many bits, or 0 for none.
+     * \param full_scale the envelope that maps to the largest amplitude
+     *        code; larger values are clipped.
+     */
+    static sptr make(
+      const std::string& path,
+      double threshold = 0.5,
+      double sample_rate = 0,
+      int amplitude_bits = 0,
+      double full_scale = 1.0);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RL_CAPTURE_SINK_H */
@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_OOK_RL_CAPTURE_SOURCE_H
+#define INCLUDED_OOK_RL_CAPTURE_SOURCE_H
+
+#include <ook/api.h>
+#include <gnuradio/sync_block.h>
+#include <cstdint>
+#include <string>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Replay a run-length capture.
+ * \ingroup ook
+ *
+ * Reads a .ookrl file written by ook::rl_capture_sink. By default each
+ * output item is one run (see ook/run.h), so connecting the block to
+ * ook::run_decoder decodes the capture without expanding it into
+ * samples. Runs longer than 2^24 samples come out in pieces.
+ *
+ * With 'envelope' set the block instead writes one float per sample:
+ * each run's recorded amplitude, or full scale and zero for captures
+ * without amplitudes. That feeds ook::decode and other sample-based
+ * blocks.
+ *
+ * Sample indices downstream count from 'start_sample'.
+ */
+class OOK_API rl_capture_source : virtual public gr::sync_block
+{
+  public:
+    typedef boost::shared_ptr<rl_capture_source> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of
+     * ook::rl_capture_source.
+     *
+     * \param path the capture to read.
+     * \param envelope output samples rather than runs.
+     * \param start_sample skip to this sample of the capture, using its
+     *        index to find it.
+     */
+    static sptr make(
+      const std::string& path,
+      bool envelope = false,
+      std::uint64_t start_sample = 0);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RL_CAPTURE_SOURCE_H */
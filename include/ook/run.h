@@ -0,0 +1,60 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_RUN_H
+#define INCLUDED_OOK_RUN_H
+
+#include <cmath>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief One run of constant level in a sliced envelope.
+ * \ingroup ook
+ *
+ * Runs are carried as plain floats so that run streams can be recorded,
+ * replayed and fanned out with the stock float blocks. The magnitude is
+ * the run's duration in samples and the sign is its level: positive for
+ * high, negative for low. Consecutive runs may share a level when a long
+ * run has been flushed in pieces.
+ */
+typedef float run_t;
+
+inline run_t make_run(bool level, float duration)
+{
+    return level ? duration : -duration;
+}
+
+inline bool run_level(run_t r)
+{
+    return r > 0;
+}
+
+inline float run_duration(run_t r)
+{
+    return std::fabs(r);
+}
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RUN_H */
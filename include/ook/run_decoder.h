@@ -0,0 +1,94 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_RUN_DECODER_H
+#define INCLUDED_OOK_RUN_DECODER_H
+
+#include <ook/api.h>
+#include <gnuradio/block.h>
+#include <cstdint>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Decode OOK packets from a stream of runs.
+ * \ingroup ook
+ *
+ * Consumes the run stream produced by ook::edge_detector and publishes
+ * packets on the 'packet' message port, exactly as ook::decode does for
+ * the equivalent sample stream.
+ */
+class OOK_API run_decoder : virtual public gr::block
+{
+  public:
+    typedef boost::shared_ptr<run_decoder> sptr;
+
+    /*!
+     * \brief Return a shared_ptr to a new instance of ook::run_decoder.
+     *
+     * \param tolerance relative tolerance applied to pulse widths.
+     * \param timestamps add 'sample_time' and 'publish_time' to each
+     *        published packet.
+     * \param expected_bits data lengths, in bits, for which a packet is
+     *        published as soon as the last bit of its check copy arrives
+     *        rather than after the trailing silence.
+     * \param learn_lengths also treat the lengths of recent valid packets
+     *        as expected.
+     * \param sample_rate input sample rate in Hz, or 0 if unknown. It
+     *        enables the pulse width limits and 'sync_width_us'.
+     * \param min_width_us narrowest plausible sync pulse (0: no limit).
+     * \param max_width_us widest plausible sync pulse (0: no limit).
+     * \param min_sync_count fewest sync pulses accepted before the
+     *        preamble.
+     * \param batch_size publish packets as PMT vectors of up to this
+     *        many packets on the 'packets' port instead of one message
+     *        each on 'packet'. 0 disables batching.
+     * \param batch_timeout_ms publish a partial batch once its oldest
+     *        packet has waited this long. It is only checked when
+     *        samples arrive, so if the input stalls a partial batch
+     *        waits for more input or for the flowgraph to stop. 0
+     *        publishes every work call's packets together.
+     */
+    static sptr make(
+      double tolerance = 0.1,
+      bool timestamps = false,
+      const std::vector<int>& expected_bits = std::vector<int>(),
+      bool learn_lengths = false,
+      double sample_rate = 0,
+      double min_width_us = 0,
+      double max_width_us = 0,
+      int min_sync_count = 0,
+      int batch_size = 0,
+      double batch_timeout_ms = 0);
+
+    /*!
+     * \brief Histogram of packet publication latency, as for
+     * ook::decode::latency_histogram().
+     */
+    virtual std::vector<std::uint64_t> latency_histogram() const = 0;
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RUN_DECODER_H */
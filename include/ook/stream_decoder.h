@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_STREAM_DECODER_H
+#define INCLUDED_OOK_STREAM_DECODER_H
+
+#include <ook/api.h>
+#include <ook/packet.h>
+#include <memory>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+/*!
+ * \brief Decode OOK packets from float buffers without a flowgraph.
+ * \ingroup ook
+ *
+ * Runs the same slicer and protocol logic as ook::decode, but is driven
+ * directly by the caller. State carries over between calls to feed(), so
+ * a capture may be passed in arbitrary pieces.
+ */
+class OOK_API stream_decoder
+{
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+
+  public:
+    stream_decoder(double tolerance = 0.1, double threshold = 0.5);
+    ~stream_decoder();
+
+    /*! Decode 'count' samples and return the packets they completed. */
+    std::vector<packet> feed(const float* samples, size_t count);
+
+    /*!
+     * Finish the packet in progress, if any, as if the input had gone
+     * quiet. Use at the end of a capture; samples fed afterwards are
+     * numbered on from where it ended.
+     */
+    std::vector<packet> flush();
+};
+
+/*!
+ * \brief Decode a complete capture in one call.
+ *
+ * Equivalent to feeding the whole buffer to a fresh ook::stream_decoder
+ * and then flushing it.
+ */
+OOK_API std::vector<packet> decode_buffer(
+  const float* samples,
+  size_t count,
+  double tolerance = 0.1,
+  double threshold = 0.5);
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_STREAM_DECODER_H */
@@ -0,0 +1,441 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ook/core.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+#include "debug.h"
+#include "flight_recorder.h"
+#include "level_tracker.h"
+#include "packet_reader.h"
+#include "slicer.h"
+#include "squelch.h"
+#include "sync_correlator.h"
+
+namespace
+{
+/* Samples recorded ahead of a failed attempt's sync train. */
+const uint64_t record_margin = 1024;
+
+/*
+ * Converts a threshold given as a fraction of full scale into the
+ * native sample type, so the slicer compares samples without
+ * converting them.
+ */
+template <class T>
+T scale_threshold(double threshold)
+{
+    return (T)std::lround(threshold * std::numeric_limits<T>::max());
+}
+
+template <>
+float scale_threshold<float>(double threshold)
+{
+    return (float)threshold;
+}
+
+/* The sample value that corresponds to a level of 1.0. */
+template <class T>
+double full_scale()
+{
+    return std::numeric_limits<T>::max();
+}
+
+template <>
+double full_scale<float>()
+{
+    return 1.0;
+}
+
+/* The envelope at a level of 1.0 full scale, converted if need be. */
+const float* to_float(const float* in, int, std::vector<float>&)
+{
+    return in;
+}
+
+template <class T>
+const float* to_float(const T* in, int n, std::vector<float>& out)
+{
+    const float scale = 1.0f / full_scale<T>();
+    out.resize(n);
+    for (int i = 0; i < n; ++i) {
+        out[i] = in[i] * scale;
+    }
+    return out.data();
+}
+}
+
+namespace gr
+{
+namespace ook
+{
+namespace core
+{
+using namespace gr::ook::util;
+
+packet to_packet(const packet_info& info)
+{
+    packet result;
+    result.data.assign(info.data, info.data + info.size);
+    result.bit_count = info.bit_count;
+    result.sync_count = info.sync_count;
+    result.sync_width = info.sync_width;
+    result.sync_width_us = info.sync_width_us;
+    result.valid_check = info.valid_check;
+    result.start_sample = info.start_sample;
+    result.end_sample = info.end_sample;
+    result.has_levels = info.has_levels;
+    result.rssi = info.rssi;
+    result.noise = info.noise;
+    result.snr = info.snr;
+    result.pretty = info.pretty;
+    result.phy_pretty = info.phy_pretty;
+    return result;
+}
+
+template <class T>
+struct basic_decoder<T>::impl {
+    /* Samples are sliced in blocks of this size to bound scratch space. */
+    static constexpr size_t block_size = 1 << 16;
+
+    const callback on_packet;
+    const double sample_rate;
+    util::slicer<T> slicer;
+    util::packet_reader reader;
+    std::vector<run_t> runs;
+    const bool levels;
+    util::level_tracker tracker;
+    std::vector<util::run_sums> sums;
+    util::squelch<T> squelch;
+    std::unique_ptr<util::flight_recorder> recorder;
+    util::sample_ring<T> ring;
+    std::unique_ptr<util::sync_correlator> correlator;
+    std::vector<float> envelope;
+    std::deque<run_t> pending;
+    std::vector<run_t> ready;
+    double fed = 0;
+    bool degraded = false;
+    bool verbose = false;
+
+    impl(const decoder_config& config, callback on_packet);
+
+    void apply(const decoder_settings& s);
+    void process(const T* in, int count);
+
+    /* Slice 'n' samples into 'runs' from index 'at'; returns the count. */
+    int slice(const T* in, int n, int at);
+    /* As above for samples the squelch found idle. */
+    int slice_idle(const T* in, int n, int at);
+    /*
+     * Pass 'nruns' new runs to the reader once the correlator has
+     * searched their samples for sync trains.
+     */
+    void feed_correlated(const T* in, int count, int nruns);
+    void feed_decided();
+    void record_failures();
+    void deliver_packets();
+};
+
+template <class T>
+constexpr size_t basic_decoder<T>::impl::block_size;
+
+template <class T>
+basic_decoder<T>::impl::impl(
+  const decoder_config& config,
+  callback on_packet) :
+    on_packet(std::move(on_packet)),
+    sample_rate(config.sample_rate),
+    slicer(scale_threshold<T>(config.settings.threshold), config.interpolate),
+    reader(config.settings.tolerance),
+    runs(block_size + util::squelch<T>::preroll),
+    levels(config.levels),
+    tracker(full_scale<T>()),
+    squelch(config.squelch * full_scale<T>()),
+    ring(config.record_prefix.empty() ? 0 : config.record_ring)
+{
+    if (levels) {
+        sums.resize(runs.size());
+    }
+    if (!config.record_prefix.empty()) {
+        if (config.record_ring < 1) {
+            throw std::invalid_argument("decode: record_ring must be positive");
+        }
+        recorder.reset(new util::flight_recorder(
+          config.record_prefix,
+          config.record_files,
+          config.record_kb_per_s * 1024));
+        reader.set_report_failures(true);
+    }
+    const auto& s = config.settings;
+    if (config.sync_correlation > 0) {
+        if (sample_rate <= 0 || s.min_width_us <= 0 || s.max_width_us <= 0) {
+            throw std::invalid_argument(
+              "decode: sync_correlation needs sample_rate, min_width_us "
+              "and max_width_us");
+        }
+        correlator.reset(new util::sync_correlator(
+          s.threshold,
+          std::max((int)std::lround(s.min_width_us * sample_rate / 1e6), 1),
+          (int)std::lround(s.max_width_us * sample_rate / 1e6),
+          config.sync_correlation));
+        reader.set_sync_hints(true);
+    }
+    reader.set_fractional(config.interpolate);
+    apply(s);
+}
+
+template <class T>
+void basic_decoder<T>::impl::apply(const decoder_settings& s)
+{
+    slicer.set_threshold(scale_threshold<T>(s.threshold));
+    if (correlator) {
+        correlator->set_threshold(s.threshold);
+    }
+    reader.set_tolerance(s.tolerance);
+    reader.set_limits(
+      sample_rate, s.min_width_us, s.max_width_us, s.min_sync_count);
+    reader.expect_lengths(s.expected_bits, s.learn_lengths);
+    verbose = s.verbose;
+}
+
+template <class T>
+int basic_decoder<T>::impl::slice(const T* in, int n, int at)
+{
+    if (!levels) {
+        return slicer.slice(in, n, runs.data() + at);
+    }
+
+    int count = slicer.slice(in, n, runs.data() + at, sums.data() + at);
+    tracker.add(runs.data() + at, sums.data() + at, count);
+    return count;
+}
+
+template <class T>
+int basic_decoder<T>::impl::slice_idle(const T* in, int n, int at)
+{
+    int count = slicer.force_low(in, n, runs.data() + at);
+    if (levels) {
+        tracker.add(runs.data() + at, nullptr, count);
+    }
+    return count;
+}
+
+template <class T>
+void basic_decoder<T>::impl::feed_correlated(
+  const T* in,
+  int count,
+  int nruns)
+{
+    correlator->process(to_float(in, count, envelope), count);
+    pending.insert(pending.end(), runs.begin(), runs.begin() + nruns);
+    feed_decided();
+}
+
+template <class T>
+void basic_decoder<T>::impl::feed_decided()
+{
+    while (correlator->has_hint()) {
+        const auto hint = correlator->next_hint();
+        reader.add_sync_hint(hint.sample, hint.width);
+    }
+
+    /* Split the run that straddles the searched part of the input. */
+    const double decided = correlator->decided();
+    ready.clear();
+    while (!pending.empty() && fed < decided) {
+        const run_t run = pending.front();
+        const double duration = run_duration(run);
+        if (fed + duration <= decided) {
+            ready.push_back(run);
+            pending.pop_front();
+            fed += duration;
+        } else {
+            const double part = decided - fed;
+            ready.push_back(make_run(run_level(run), part));
+            pending.front() = make_run(run_level(run), duration - part);
+            fed = decided;
+        }
+    }
+
+    reader.resume(ready.data(), ready.size());
+}
+
+template <class T>
+void basic_decoder<T>::impl::record_failures()
+{
+    while (reader.has_failure()) {
+        auto failure = reader.next_failure();
+        const uint64_t start = std::max(
+          ring.begin(),
+          failure.start_sample > record_margin
+            ? failure.start_sample - record_margin
+            : 0);
+        const uint64_t stop = failure.end_sample + 1;
+        if (start >= stop || !recorder->admit(stop - start)) {
+            continue;
+        }
+
+        std::vector<float> samples(stop - start);
+        ring.copy(start, stop, samples.data(), full_scale<T>());
+        recorder->record(
+          std::move(samples),
+          start,
+          failure.start_sample,
+          failure.end_sample,
+          failure.reason);
+    }
+}
+
+template <class T>
+void basic_decoder<T>::impl::deliver_packets()
+{
+    if (recorder) {
+        record_failures();
+    }
+
+    while (reader.has_packet()) {
+        auto p = reader.next_packet();
+        if (levels) {
+            tracker.measure(p);
+        }
+        const packet_info info = { p.data.data(),    p.data.size(),
+                                   p.bit_count,      p.sync_count,
+                                   p.sync_width,     p.sync_width_us,
+                                   p.valid_check,    p.start_sample,
+                                   p.end_sample,     p.has_levels,
+                                   p.rssi,           p.noise,
+                                   p.snr,            p.pretty.c_str(),
+                                   p.phy_pretty.c_str() };
+        on_packet(info);
+    }
+}
+
+template <class T>
+void basic_decoder<T>::impl::process(const T* in, int count)
+{
+    if (recorder) {
+        ring.push(in, count);
+    }
+
+    int nruns = 0;
+    if (squelch.enabled()) {
+        squelch.process(
+          in, count, [this, &nruns](const T* span, int n, bool idle) {
+              nruns +=
+                idle ? slice_idle(span, n, nruns) : slice(span, n, nruns);
+          });
+    } else {
+        if (degraded && reader.idle()) {
+            nruns = slicer.skip_idle(
+              in, count, reader.min_pulse_width(), runs.data());
+            if (nruns && levels) {
+                tracker.add(runs.data(), nullptr, nruns);
+            }
+        }
+        if (!nruns) {
+            nruns = slice(in, count, 0);
+        }
+    }
+    if (correlator) {
+        feed_correlated(in, count, nruns);
+    } else {
+        reader.resume(runs.data(), nruns);
+    }
+    deliver_packets();
+}
+
+template <class T>
+basic_decoder<T>::basic_decoder(
+  const decoder_config& config,
+  callback on_packet) :
+    impl_(new impl(config, std::move(on_packet)))
+{
+}
+
+template <class T>
+basic_decoder<T>::~basic_decoder()
+{
+}
+
+template <class T>
+void basic_decoder<T>::feed(const T* samples, size_t count)
+{
+    debug_mute(impl_->degraded);
+    debug_enable(impl_->verbose ? debug_flags::decode : debug_flags::none);
+    while (count) {
+        int n = (int)std::min(count, impl::block_size);
+        impl_->process(samples, n);
+        samples += n;
+        count -= n;
+    }
+    debug_mute(false);
+    debug_enable(debug_flags::none);
+}
+
+template <class T>
+void basic_decoder<T>::flush()
+{
+    if (impl_->correlator) {
+        impl_->correlator->flush();
+        /*
+         * Runs past the last whole decimation step stay pending until
+         * more input is searched.
+         */
+        impl_->feed_decided();
+    }
+
+    impl_->reader.finish();
+    impl_->deliver_packets();
+
+    if (impl_->recorder) {
+        impl_->recorder->flush();
+    }
+}
+
+template <class T>
+void basic_decoder<T>::update(const decoder_settings& settings)
+{
+    impl* self = impl_.get();
+    impl_->reader.between_packets(
+      [self, settings]() { self->apply(settings); });
+}
+
+template <class T>
+void basic_decoder<T>::set_degraded(bool degraded)
+{
+    impl_->degraded = degraded;
+    impl_->reader.set_degraded(degraded);
+}
+
+template class basic_decoder<float>;
+template class basic_decoder<std::int16_t>;
+template class basic_decoder<std::int8_t>;
+
+} /* namespace core */
+} /* namespace ook */
+} /* namespace gr */
@@ -0,0 +1,207 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ook/core.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+#include "coroutine.h"
+#include "encoder.h"
+
+namespace gr
+{
+namespace ook
+{
+namespace core
+{
+struct transmitter::impl : public util::coroutine {
+    /* A packet waiting to be sent, with whatever keeps its data alive. */
+    struct queued {
+        const uint8_t* data;
+        size_t size;
+        std::shared_ptr<const void> owner;
+    };
+
+    int stop_after;
+    int ms_between_xmit;
+    const int ms;
+    const util::encoder encoder;
+
+    float* begin;
+    float* out;
+    float* endptr;
+
+    std::mutex queue_mutex;
+    std::deque<queued> packet_queue;
+    std::vector<transmission> boundaries;
+    /* Keeps the packets of 'boundaries' alive until they are reported. */
+    std::vector<std::shared_ptr<const void>> reported;
+    uint64_t seq;
+
+    impl(int stop_after, int ms_between_xmit, int sample_rate) :
+        stop_after(stop_after),
+        ms_between_xmit(ms_between_xmit),
+        ms(sample_rate / 1000),
+        encoder(sample_rate),
+        begin(nullptr),
+        out(nullptr),
+        endptr(nullptr),
+        seq(0)
+    {
+    }
+
+    void wait_for_space()
+    {
+        while (out == endptr) {
+            yield();
+        }
+    }
+
+    void produce(float value)
+    {
+        wait_for_space();
+
+        *out = value;
+        out++;
+    }
+
+    void produce_many(int n, float value)
+    {
+        for (int i = 0; i < n; ++i) {
+            produce(value);
+        }
+    }
+
+    void blank(int time = 10)
+    {
+        produce_many(time * ms, 0.0f);
+    }
+
+    bool next_packet(queued& packet)
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (packet_queue.empty()) {
+            return false;
+        }
+        packet = std::move(packet_queue.front());
+        packet_queue.pop_front();
+        return true;
+    }
+
+    void send_packet(const queued& packet)
+    {
+        transmission boundary = {
+            0, true, seq++, packet.data, packet.size, packet.owner.get()
+        };
+
+        blank();
+
+        /*
+         * The first sample is reported once there is room for it, so
+         * that it is written by the same call that reports it. The last
+         * one always is, since produce() only yields before it writes.
+         */
+        wait_for_space();
+        boundary.offset = (int)(out - begin);
+        boundaries.push_back(boundary);
+        reported.push_back(packet.owner);
+        encoder.transmit(packet.data, packet.size, [this](int n, float value) {
+            produce_many(n, value);
+        });
+        boundary.offset = (int)(out - begin) - 1;
+        boundary.start = false;
+        boundaries.push_back(boundary);
+        reported.push_back(packet.owner);
+
+        blank(ms_between_xmit);
+        stop_after = std::max(-1, stop_after - 1);
+    }
+
+    void run()
+    {
+        while (stop_after) {
+            queued packet;
+            while (!next_packet(packet)) {
+                blank();
+            }
+            send_packet(packet);
+        }
+    }
+
+    int resume(float* data, int size)
+    {
+        if (stop_after == 0) {
+            return 0;
+        }
+
+        begin = data;
+        out = data;
+        endptr = data + size;
+        coroutine::resume();
+
+        return (int)(out - data);
+    }
+};
+
+transmitter::transmitter(int stop_after, int ms_between_xmit, int sample_rate) :
+    impl_(new impl(stop_after, ms_between_xmit, sample_rate))
+{
+}
+
+transmitter::~transmitter()
+{
+}
+
+void transmitter::enqueue(
+  const std::uint8_t* data,
+  size_t size,
+  std::shared_ptr<const void> owner)
+{
+    std::lock_guard<std::mutex> lock(impl_->queue_mutex);
+    impl_->packet_queue.push_back({ data, size, std::move(owner) });
+}
+
+void transmitter::enqueue(const std::vector<std::uint8_t>& data)
+{
+    auto copy = std::make_shared<std::vector<std::uint8_t>>(data);
+    enqueue(copy->data(), copy->size(), copy);
+}
+
+int transmitter::generate(float* out, int n, const callback& on_boundary)
+{
+    const int result = impl_->resume(out, n);
+    if (on_boundary) {
+        for (const auto& boundary : impl_->boundaries) {
+            on_boundary(boundary);
+        }
+    }
+    impl_->boundaries.clear();
+    impl_->reported.clear();
+    return result;
+}
+
+} /* namespace core */
+} /* namespace ook */
+} /* namespace gr */
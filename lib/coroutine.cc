@@ -24,6 +24,7 @@
 
 #include "coroutine.h"
 #include "debug.h"
+#include "stack_pool.h"
 
 #include <cassert>
 #include <ucontext.h>
@@ -34,14 +35,21 @@ using namespace gr::ook::util;
 
 struct coroutine::coroutine_impl {
     ucontext_t run_ctxt;
-    ucontext_t return_ctxt;
     ucontext_t main_ctxt;
     bool returned = true;
 
-    static constexpr size_t rstack_size = 1 << 14;
-    static constexpr size_t fstack_size = 1 << 12;
-    char rstack[rstack_size];
-    char fstack[fstack_size];
+    stack_pool::stack stack;
+
+    coroutine_impl(size_t stack_size) :
+        stack(stack_pool::instance().acquire(
+          stack_size ? stack_size : stack_pool::default_size()))
+    {
+    }
+
+    ~coroutine_impl()
+    {
+        stack_pool::instance().release(stack);
+    }
 
     void reset(coroutine* cr)
     {
@@ -50,50 +58,50 @@ struct coroutine::coroutine_impl {
         returned = false;
 
         getcontext(&run_ctxt);
-        getcontext(&return_ctxt);
         getcontext(&main_ctxt);
 
-        run_ctxt.uc_stack.ss_sp = rstack;
-        run_ctxt.uc_stack.ss_size = rstack_size;
-        run_ctxt.uc_link = &return_ctxt;
+        run_ctxt.uc_stack.ss_sp = stack.base;
+        run_ctxt.uc_stack.ss_size = stack.size;
+        run_ctxt.uc_link = nullptr;
 
         makecontext(&run_ctxt, (void (*)()) & run, 1, cr);
 
         cr->on_reset();
     }
 
-    static void fallthrough(coroutine* cr)
-    {
-        debug(debug_flags::coroutine, "coroutine fallthrough %p\n", cr);
-        cr->impl->returned = true;
-        cr->on_exit();
-    }
-
-    void pre_run(coroutine* cr)
-    {
-        return_ctxt.uc_stack.ss_sp = fstack;
-        return_ctxt.uc_stack.ss_size = fstack_size;
-        return_ctxt.uc_link = &main_ctxt;
-
-        makecontext(&return_ctxt, (void (*)()) & fallthrough, 1, cr);
-    }
-
     static void run(coroutine* cr)
     {
         debug(debug_flags::coroutine, "coroutine run %p\n", cr);
-        cr->impl->pre_run(cr);
         cr->run();
+
+        /*
+         * Finish up on the coroutine's own stack and switch straight
+         * back to the caller. Falling off the end would go through
+         * uc_link, which needs a second stack to run on.
+         */
+        debug(debug_flags::coroutine, "coroutine fallthrough %p\n", cr);
+        cr->impl->returned = true;
+        cr->on_exit();
+        setcontext(&cr->impl->main_ctxt);
     }
 };
 
 
-coroutine::coroutine() : impl(new coroutine_impl{})
+coroutine::coroutine(size_t stack_size) : impl(new coroutine_impl{stack_size})
 {
     reset();
 }
 
 coroutine::~coroutine()
 {
+    if (debugEnabled(debug_flags::stack)) {
+        debug(
+          debug_flags::stack,
+          "coroutine %p peak stack %zu of %zu bytes\n",
+          this,
+          stack_high_water(),
+          stack_size());
+    }
 }
 
 void coroutine::resume()
@@ -114,3 +122,16 @@ void coroutine::yield()
     debug(debug_flags::coroutine, "coroutine yield %p\n", this);
     swapcontext(&impl->run_ctxt, &impl->main_ctxt);
 }
+
+size_t coroutine::stack_size() const
+{
+    return impl->stack.size;
+}
+
+size_t coroutine::stack_high_water() const
+{
+    if (!debugEnabled(debug_flags::stack)) {
+        return 0;
+    }
+    return stack_pool::high_water(impl->stack);
+}
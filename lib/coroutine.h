@@ -21,6 +21,7 @@
 #ifndef INCLUDED_OOK_COROUTINE_H
 #define INCLUDED_OOK_COROUTINE_H
 
+#include <cstddef>
 #include <memory>
 
 namespace gr
@@ -34,6 +35,9 @@ namespace util
  * and implement the body of the coroutine in the 'run()' method. The coroutine
  * can be started (or resumed) by calling 'resume()'. The coroutine function can
  * call 'yield()' to yield back to the calling context.
+ *
+ * The coroutine runs on a stack taken from util::stack_pool. A size of
+ * zero selects stack_pool::default_size().
  */
 class coroutine
 {
@@ -49,7 +53,7 @@ class coroutine
     /* Callback invoked when the coroutine is reset. */
     virtual void on_reset() {}
   public:
-    coroutine();
+    explicit coroutine(size_t stack_size = 0);
     virtual ~coroutine();
 
     /* Resume execution of the coroutine. */
@@ -62,6 +66,16 @@ class coroutine
      */
     void reset();
 
+    /* The usable size of the coroutine's stack, in bytes. */
+    size_t stack_size() const;
+
+    /*
+     * The deepest stack usage seen so far, in bytes. Only available
+     * when stack debugging (OOK_STACK_DEBUG) is enabled; returns zero
+     * otherwise.
+     */
+    size_t stack_high_water() const;
+
   protected:
     /*
      * Pause execution of this coroutine and resume the
@@ -46,20 +46,26 @@ debug_flags::type init_debug_flags()
         result = (debug_flags::type)(result | debug_flags::coroutine);
     }
 
+    if (getenv("OOK_STACK_DEBUG") != 0) {
+        result = (debug_flags::type)(result | debug_flags::stack);
+    }
+
     return result;
 }
 
 debug_flags::type enabled = init_debug_flags();
+thread_local bool muted = false;
+thread_local debug_flags::type forced = debug_flags::none;
 }
 
 bool gr::ook::util::debugEnabled(debug_flags::type flag)
 {
-    return enabled & flag;
+    return (enabled | forced) & flag;
 }
 
 void gr::ook::util::debug(debug_flags::type from, const char* fmt, ...)
 {
-    if (!debugEnabled(from)) return;
+    if (!debugEnabled(from) || muted) return;
 
     fprintf(stderr, "debug: ");
 
@@ -68,3 +74,13 @@ void gr::ook::util::debug(debug_flags::type from, const char* fmt, ...)
     vfprintf(stderr, fmt, args);
     va_end(args);
 }
+
+void gr::ook::util::debug_mute(bool mute)
+{
+    muted = mute;
+}
+
+void gr::ook::util::debug_enable(debug_flags::type flags)
+{
+    forced = flags;
+}
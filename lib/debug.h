@@ -32,7 +32,8 @@ namespace debug_flags
 enum type {
     none = 0,
     decode = 1 << 0,
-    coroutine = 1 << 1
+    coroutine = 1 << 1,
+    stack = 1 << 2
 };
 }
 
@@ -40,6 +41,15 @@ bool debugEnabled(debug_flags::type);
 
 void debug(debug_flags::type from, const char* fmt, ...);
 
+/* Drop all debug output from the calling thread while 'muted' is set. */
+void debug_mute(bool muted);
+
+/*
+ * Also print debug output for 'flags' from the calling thread, whatever
+ * the environment enables; debug_flags::none goes back to that alone.
+ */
+void debug_enable(debug_flags::type flags);
+
 } // namespace util
 } // namespace ook
 } // namespace gr
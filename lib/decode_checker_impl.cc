@@ -0,0 +1,260 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "decode_checker_impl.h"
+
+namespace
+{
+const pmt::pmt_t packet_sym = pmt::mp("packet");
+const pmt::pmt_t result_sym = pmt::mp("result");
+const pmt::pmt_t packet_start_sym = pmt::mp("packet_start");
+const pmt::pmt_t packet_end_sym = pmt::mp("packet_end");
+const pmt::pmt_t seq_sym = pmt::mp("seq");
+const pmt::pmt_t data_sym = pmt::mp("data");
+const pmt::pmt_t start_sample_sym = pmt::mp("start_sample");
+const pmt::pmt_t end_sample_sym = pmt::mp("end_sample");
+const pmt::pmt_t status_sym = pmt::mp("status");
+const pmt::pmt_t latency_sym = pmt::mp("latency");
+const pmt::pmt_t detected_sym = pmt::mp("detected");
+const pmt::pmt_t false_positive_sym = pmt::mp("false_positive");
+
+std::vector<uint8_t> payload(const pmt::pmt_t& dict)
+{
+    auto data = pmt::dict_ref(dict, data_sym, pmt::PMT_NIL);
+    if (!pmt::is_u8vector(data)) {
+        return std::vector<uint8_t>();
+    }
+
+    size_t size = 0;
+    const uint8_t* bytes = pmt::u8vector_elements(data, size);
+    return std::vector<uint8_t>(bytes, bytes + size);
+}
+
+uint64_t sample(const pmt::pmt_t& packet, const pmt::pmt_t& key)
+{
+    auto value = pmt::dict_ref(packet, key, pmt::PMT_NIL);
+    if (pmt::is_null(value)) {
+        throw std::invalid_argument(
+          "decode_checker: packet without " + pmt::symbol_to_string(key));
+    }
+    return pmt::to_uint64(value);
+}
+}
+
+namespace gr
+{
+namespace ook
+{
+constexpr size_t decode_checker_impl::max_transmissions;
+
+decode_checker::sptr decode_checker::make()
+{
+    return gnuradio::get_initial_sptr(new decode_checker_impl());
+}
+
+/*
+ * The private constructor
+ */
+decode_checker_impl::decode_checker_impl()
+    : gr::sync_block(
+        "decode_checker",
+        gr::io_signature::make(1, 1, sizeof(float)),
+        gr::io_signature::make(0, 0, 0)),
+      seen_(0),
+      transmitted_(0),
+      detected_(0),
+      false_positives_(0)
+{
+    message_port_register_in(packet_sym);
+    set_msg_handler(
+      packet_sym, [this](pmt::pmt_t p) { handle_packet(p); });
+    message_port_register_out(result_sym);
+}
+
+/*
+ * Our virtual destructor.
+ */
+decode_checker_impl::~decode_checker_impl()
+{
+}
+
+bool decode_checker_impl::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    check_pending(true);
+    return true;
+}
+
+uint64_t decode_checker_impl::transmitted() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return transmitted_;
+}
+
+uint64_t decode_checker_impl::detected() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return detected_;
+}
+
+uint64_t decode_checker_impl::false_positives() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return false_positives_;
+}
+
+double decode_checker_impl::detection_rate() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return transmitted_ ? (double)detected_ / transmitted_ : 0;
+}
+
+std::vector<uint64_t> decode_checker_impl::latencies() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latencies_;
+}
+
+void decode_checker_impl::handle_packet(pmt::pmt_t msg)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pmt::is_vector(msg)) {
+        for (size_t i = 0; i < pmt::length(msg); ++i) {
+            pending_.push_back(pmt::vector_ref(msg, i));
+        }
+    } else if (pmt::is_dict(msg)) {
+        pending_.push_back(msg);
+    } else {
+        throw std::invalid_argument("decode_checker expects packet dicts");
+    }
+    check_pending(false);
+}
+
+void decode_checker_impl::handle_tag(const gr::tag_t& tag)
+{
+    if (pmt::eqv(tag.key, packet_start_sym)) {
+        transmissions_.push_back({
+          pmt::to_uint64(pmt::dict_ref(tag.value, seq_sym, pmt::PMT_NIL)),
+          payload(tag.value),
+          tag.offset,
+          tag.offset,
+          false,
+          false });
+        transmitted_++;
+        if (transmissions_.size() > max_transmissions) {
+            transmissions_.pop_front();
+        }
+    } else if (pmt::eqv(tag.key, packet_end_sym)) {
+        auto seq =
+          pmt::to_uint64(pmt::dict_ref(tag.value, seq_sym, pmt::PMT_NIL));
+        for (auto& t : transmissions_) {
+            if (t.seq == seq && !t.ended) {
+                t.end = tag.offset;
+                t.ended = true;
+                break;
+            }
+        }
+    }
+}
+
+void decode_checker_impl::check_pending(bool all)
+{
+    while (!pending_.empty() &&
+           (all || sample(pending_.front(), end_sample_sym) < seen_)) {
+        check(pending_.front());
+        pending_.pop_front();
+    }
+
+    while (!transmissions_.empty() && transmissions_.front().detected) {
+        transmissions_.pop_front();
+    }
+}
+
+void decode_checker_impl::check(const pmt::pmt_t& packet)
+{
+    const auto start = sample(packet, start_sample_sym);
+    const auto end = sample(packet, end_sample_sym);
+    const auto data = payload(packet);
+
+    auto result = pmt::make_dict();
+    for (auto& t : transmissions_) {
+        if (t.start > end) {
+            break;
+        }
+        if (t.detected || (t.ended && t.end < start) || t.data != data) {
+            continue;
+        }
+
+        const uint64_t latency = t.ended && end > t.end ? end - t.end : 0;
+        t.detected = true;
+        detected_++;
+        latencies_.push_back(latency);
+
+        result = pmt::dict_add(result, status_sym, detected_sym);
+        result = pmt::dict_add(result, seq_sym, pmt::from_uint64(t.seq));
+        result = pmt::dict_add(result, latency_sym, pmt::from_uint64(latency));
+        result = pmt::dict_add(result, packet_sym, packet);
+        message_port_pub(result_sym, result);
+        return;
+    }
+
+    false_positives_++;
+    result = pmt::dict_add(result, status_sym, false_positive_sym);
+    result = pmt::dict_add(result, packet_sym, packet);
+    message_port_pub(result_sym, result);
+}
+
+int decode_checker_impl::work(
+  int noutput_items,
+  gr_vector_const_void_star& input_items,
+  gr_vector_void_star& output_items)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const uint64_t start = nitems_read(0);
+    std::vector<gr::tag_t> tags;
+    get_tags_in_range(tags, 0, start, start + noutput_items);
+    std::sort(
+      tags.begin(),
+      tags.end(),
+      [](const gr::tag_t& a, const gr::tag_t& b) {
+          return a.offset < b.offset;
+      });
+    for (const auto& tag : tags) {
+        handle_tag(tag);
+    }
+
+    seen_ = start + noutput_items;
+    check_pending(false);
+
+    return noutput_items;
+}
+
+} /* namespace ook */
+} /* namespace gr */
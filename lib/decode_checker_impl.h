@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_OOK_DECODE_CHECKER_IMPL_H
+#define INCLUDED_OOK_DECODE_CHECKER_IMPL_H
+
+#include <ook/decode_checker.h>
+#include <deque>
+#include <mutex>
+
+namespace gr
+{
+namespace ook
+{
+class decode_checker_impl : public decode_checker
+{
+  private:
+    struct transmission {
+        std::uint64_t seq;
+        std::vector<std::uint8_t> data;
+        std::uint64_t start;
+        std::uint64_t end;
+        bool ended;
+        bool detected;
+    };
+
+    /*
+     * Transmissions that are never detected would otherwise be kept
+     * forever; beyond this many the oldest are forgotten.
+     */
+    static constexpr size_t max_transmissions = 4096;
+
+    mutable std::mutex mutex_;
+    /* Ordered by start sample. */
+    std::deque<transmission> transmissions_;
+    /* Packets waiting for the tags up to their end sample. */
+    std::deque<pmt::pmt_t> pending_;
+    /* Number of input samples whose tags have been read. */
+    std::uint64_t seen_;
+
+    std::uint64_t transmitted_;
+    std::uint64_t detected_;
+    std::uint64_t false_positives_;
+    std::vector<std::uint64_t> latencies_;
+
+    void handle_packet(pmt::pmt_t msg);
+    void handle_tag(const gr::tag_t& tag);
+    /* Judge the pending packets; only those already covered unless 'all'. */
+    void check_pending(bool all);
+    void check(const pmt::pmt_t& packet);
+
+  public:
+    decode_checker_impl();
+    ~decode_checker_impl();
+
+    bool stop();
+
+    std::uint64_t transmitted() const;
+    std::uint64_t detected() const;
+    std::uint64_t false_positives() const;
+    double detection_rate() const;
+    std::vector<std::uint64_t> latencies() const;
+
+    int work(
+      int noutput_items,
+      gr_vector_const_void_star& input_items,
+      gr_vector_void_star& output_items);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_DECODE_CHECKER_IMPL_H */
@@ -23,490 +23,425 @@
 #endif
 
 #include <gnuradio/io_signature.h>
-#include <cassert>
-#include <cstdio>
-#include <deque>
+#include <cmath>
 #include <stdexcept>
-#include <ucontext.h>
 
-#include "coroutine.h"
-#include "debug.h"
 #include "decode_impl.h"
-
-using namespace gr;
-using namespace gr::ook;
-using namespace gr::ook::util;
+#include "packet_pmt.h"
 
 namespace
 {
-bool within_range(double act, double exp, double tolerance)
+const pmt::pmt_t packet_sym = pmt::mp("packet");
+const pmt::pmt_t packets_sym = pmt::mp("packets");
+const pmt::pmt_t overload_sym = pmt::mp("overload");
+const pmt::pmt_t overloaded_sym = pmt::mp("overloaded");
+const pmt::pmt_t load_sym = pmt::mp("load");
+const pmt::pmt_t missed_deadlines_sym = pmt::mp("missed_deadlines");
+const pmt::pmt_t sample_sym = pmt::mp("sample");
+const pmt::pmt_t config_sym = pmt::mp("config");
+const pmt::pmt_t tolerance_sym = pmt::mp("tolerance");
+const pmt::pmt_t threshold_sym = pmt::mp("threshold");
+const pmt::pmt_t min_width_us_sym = pmt::mp("min_width_us");
+const pmt::pmt_t max_width_us_sym = pmt::mp("max_width_us");
+const pmt::pmt_t min_sync_count_sym = pmt::mp("min_sync_count");
+const pmt::pmt_t expected_bits_sym = pmt::mp("expected_bits");
+const pmt::pmt_t learn_lengths_sym = pmt::mp("learn_lengths");
+const pmt::pmt_t verbose_sym = pmt::mp("verbose");
+
+double config_number(const pmt::pmt_t& key, const pmt::pmt_t& value)
 {
-    double max = exp * (1.0f + tolerance);
-    double min = exp * (1.0f - tolerance);
-
-    return (act > min) && (act < max);
-}
-
-struct timeout_error : public std::runtime_error {
-    timeout_error() :
-        std::runtime_error("timeout reading data")
-    { }
-};
-
-struct too_many_bits_error : public std::runtime_error {
-    too_many_bits_error() :
-        std::runtime_error("exceeded max allowed data bits")
-    { }
-};
-
-struct bad_transition_error : public std::runtime_error {
-    bad_transition_error() :
-        std::runtime_error("signal did not transition when expected")
-    { }
-};
-
-struct bad_midamble_error : public std::runtime_error {
-    bad_midamble_error() :
-        std::runtime_error("bad midamble")
-    { }
-};
-}
-
-struct decode_impl::worker : public util::coroutine {
-    worker(double tolerance_) : tolerance(tolerance_)
-    {
-    }
-
-    double tolerance;
-    bool need_reset = false;
-
-    const float* data = nullptr;
-    const float* endptr = nullptr;
-
-    int sync_count = 0;
-    std::vector<bool> packet_data;
-    std::vector<bool> packet_check;
-
-    pmt::pmt_t packet_sym = pmt::mp("packet");
-    std::deque<pmt::pmt_t> packet_queue;
-
-    struct timing_params {
-        timing_params() :
-            one(0),
-            zero(0),
-            preamble(0),
-            end(0),
-            timeout(-1)
-        { }
-
-        timing_params(int width) :
-            one(width),
-            zero(width / 2),
-            preamble(width * 2),
-            end(width * 4),
-            timeout(width * 8)
-        { }
-
-        int one, zero, preamble, end, timeout;
-    } timing;
-
-    virtual void on_reset() override
-    {
-        need_reset = false;
-        sync_count = 0;
-        packet_data.clear();
-        packet_check.clear();
-        timing = { };
-    }
-
-    bool has_next() const
-    {
-        return data != endptr;
-    }
-
-    float peek_next()
-    {
-        while (!has_next()) {
-            yield();
-        }
-        return *data;
-    }
-
-    float next()
-    {
-        while (!has_next()) {
-            yield();
-        }
-
-        float result = *data;
-        data++;
-        return result;
-    }
-
-    static bool is_high(float f)
-    {
-        return f > 0.5;
-    }
-
-    static bool is_low(float f)
-    {
-        return f < 0.5;
-    }
-
-    int count_until(bool (*fn)(float), int max)
-    {
-        int count = 0;
-        while (!fn(next()) && (max == -1 || count < max)) {
-            count++;
-        }
-        if (max != -1 && count > max) {
-            throw timeout_error{};
-        }
-        return count;
-    }
-    int count_until(bool (*fn)(float))
-    {
-        return count_until(fn, timing.timeout);
-    }
-
-    void wait_until(bool (*fn)(float), int max)
-    {
-        (void)count_until(fn, max);
-    }
-
-    void wait_until(bool (*fn)(float))
-    {
-        wait_until(fn, timing.timeout);
-    }
-
-    std::string phy_pretty_packet()
-    {
-        std::ostringstream os;
-        os << std::setw(2) << sync_count << "SP ";
-        for (size_t idx = 0;
-             idx < std::max(packet_data.size(), packet_check.size());) {
-            if (idx >= packet_data.size()) {
-                os << "C";
-            } else if (idx >= packet_check.size()) {
-                os << "D";
-            } else if (packet_data[idx] != packet_check[idx]) {
-                os << "X";
-            } else {
-                os << (packet_data[idx] ? '1' : '0');
-            }
-
-            if (++idx % 4 == 0) {
-                os << " ";
-            }
-        }
-        return os.str();
+    if (!pmt::is_number(value)) {
+        throw std::invalid_argument(
+          "decode: config " + pmt::symbol_to_string(key) +
+          " must be a number");
     }
+    return pmt::to_double(value);
+}
 
-    pmt::pmt_t pretty_packet(const std::vector<uint8_t> data, bool check_valid)
-    {
-        std::ostringstream os;
-        os << std::setfill('0');
-        os << std::setw(2) << sync_count << "S ";
-        os << std::setw(3) << packet_data.size() << "B ";
-        os << (check_valid ? "\u2713" : "\u2717");
-        for (auto c : data) {
-            os << " " << std::hex << std::setw(2) << (int)c;
-        }
-        return pmt::mp(os.str());
+bool config_bool(const pmt::pmt_t& key, const pmt::pmt_t& value)
+{
+    if (!pmt::is_bool(value)) {
+        throw std::invalid_argument(
+          "decode: config " + pmt::symbol_to_string(key) + " must be a bool");
     }
+    return pmt::to_bool(value);
+}
 
-    void push_bit(bool bit, uint8_t& c, size_t idx, std::vector<uint8_t>& out)
-    {
-        c <<= 1;
-        c |= bit;
-        if (((idx + 1) % 8) == 0) {
-            out.push_back(c);
-            c = 0;
+std::vector<int> config_lengths(const pmt::pmt_t& value)
+{
+    std::vector<int> result;
+    if (pmt::is_s32vector(value)) {
+        size_t size = 0;
+        const int32_t* lengths = pmt::s32vector_elements(value, size);
+        result.assign(lengths, lengths + size);
+    } else if (pmt::is_vector(value)) {
+        for (size_t i = 0; i < pmt::length(value); ++i) {
+            result.push_back((int)std::lround(
+              config_number(expected_bits_sym, pmt::vector_ref(value, i))));
         }
+    } else {
+        throw std::invalid_argument(
+          "decode: config expected_bits must be a vector");
     }
+    return result;
+}
 
-    void produce_packet()
-    {
-        bool check_valid = true;
-
-        const size_t num_bytes =
-          (packet_data.size() / 8) + ((packet_data.size() % 8) != 0);
-        uint8_t byte = 0;
-        size_t idx = 0;
-        std::vector<uint8_t> data;
-        data.reserve(num_bytes);
-        for (; idx < packet_data.size(); idx++) {
-            if (idx >= packet_data.size()) {
-                check_valid = false;
-                break;
-            }
-
-            if (
-              idx >= packet_check.size() ||
-              packet_data[idx] != packet_check[idx]) {
-                check_valid = false;
-            }
+gr::ook::core::decoder_settings make_settings(
+  double tolerance,
+  double threshold,
+  const std::vector<int>& expected_bits,
+  bool learn_lengths,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count)
+{
+    gr::ook::core::decoder_settings settings;
+    settings.tolerance = tolerance;
+    settings.threshold = threshold;
+    settings.min_width_us = min_width_us;
+    settings.max_width_us = max_width_us;
+    settings.min_sync_count = min_sync_count;
+    settings.expected_bits = expected_bits;
+    settings.learn_lengths = learn_lengths;
+    return settings;
+}
 
-            push_bit(packet_data[idx], byte, idx, data);
-        }
+gr::ook::core::decoder_config make_config(
+  const gr::ook::core::decoder_settings& settings,
+  double sample_rate,
+  bool levels,
+  bool interpolate,
+  double squelch,
+  const std::string& record_prefix,
+  int record_ring,
+  int record_files,
+  double record_kb_per_s,
+  double sync_correlation)
+{
+    gr::ook::core::decoder_config config;
+    config.settings = settings;
+    config.sample_rate = sample_rate;
+    config.levels = levels;
+    config.interpolate = interpolate;
+    config.squelch = squelch;
+    config.record_prefix = record_prefix;
+    config.record_ring = record_ring;
+    config.record_files = record_files;
+    config.record_kb_per_s = record_kb_per_s;
+    config.sync_correlation = sync_correlation;
+    return config;
+}
+}
 
-        while (data.size() < num_bytes) {
-            push_bit(0, byte, idx++, data);
-        }
+namespace gr
+{
+namespace ook
+{
+template <class T>
+typename decode_blk<T>::sptr decode_blk<T>::make(
+  double tolerance,
+  double threshold,
+  bool timestamps,
+  const std::vector<int>& expected_bits,
+  bool learn_lengths,
+  double sample_rate,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count,
+  int batch_size,
+  double batch_timeout_ms,
+  double max_load,
+  bool levels,
+  bool interpolate,
+  double squelch,
+  const std::string& record_prefix,
+  int record_ring,
+  int record_files,
+  double record_kb_per_s,
+  double sync_correlation)
+{
+    return gnuradio::get_initial_sptr(new decode_impl<T>(
+      tolerance,
+      threshold,
+      timestamps,
+      expected_bits,
+      learn_lengths,
+      sample_rate,
+      min_width_us,
+      max_width_us,
+      min_sync_count,
+      batch_size,
+      batch_timeout_ms,
+      max_load,
+      levels,
+      interpolate,
+      squelch,
+      record_prefix,
+      record_ring,
+      record_files,
+      record_kb_per_s,
+      sync_correlation));
+}
 
-        auto phy_packet = phy_pretty_packet();
-        debug(debug_flags::decode, "phy: %s\n", phy_packet.c_str());
-
-        auto packet = pmt::make_dict();
-        packet = dict_add(
-            packet, pmt::mp("data"), pmt::init_u8vector(data.size(), data)
-        );
-        packet = dict_add(
-            packet, pmt::mp("pretty"), pretty_packet(data, check_valid)
-        );
-        packet = dict_add(
-            packet, pmt::mp("phy_pretty"), pmt::mp(phy_packet)
-        );
-        packet = dict_add(
-            packet, pmt::mp("bit_count"), pmt::mp(packet_data.size())
-        );
-        packet = dict_add(
-            packet, pmt::mp("sync_count"), pmt::mp(sync_count)
-        );
-        packet = dict_add(
-            packet, pmt::mp("valid_check"), pmt::from_bool(check_valid)
-        );
-
-        packet_queue.push_back(packet);
-    }
+/*
+ * The private constructor
+ */
+template <class T>
+decode_impl<T>::decode_impl(
+  double tolerance,
+  double threshold,
+  bool timestamps,
+  const std::vector<int>& expected_bits,
+  bool learn_lengths,
+  double sample_rate,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count,
+  int batch_size,
+  double batch_timeout_ms,
+  double max_load,
+  bool levels,
+  bool interpolate,
+  double squelch,
+  const std::string& record_prefix,
+  int record_ring,
+  int record_files,
+  double record_kb_per_s,
+  double sync_correlation)
+    : gr::block(
+        "decode",
+        gr::io_signature::make(1, 1, sizeof(T)),
+        gr::io_signature::make(0, 0, 0)),
+      requested_(make_settings(
+        tolerance,
+        threshold,
+        expected_bits,
+        learn_lengths,
+        min_width_us,
+        max_width_us,
+        min_sync_count)),
+      settings_changed_(false),
+      decoder_(
+        make_config(
+          requested_,
+          sample_rate,
+          levels,
+          interpolate,
+          squelch,
+          record_prefix,
+          record_ring,
+          record_files,
+          record_kb_per_s,
+          sync_correlation),
+        [this](const core::packet_info& info) { publish_packet(info); }),
+      timestamps_(timestamps),
+      batch_(batch_size, batch_timeout_ms),
+      load_(sample_rate, max_load)
+{
+    this->message_port_register_out(packet_sym);
+    this->message_port_register_out(packets_sym);
+    this->message_port_register_out(overload_sym);
+    this->message_port_register_in(config_sym);
+    this->set_msg_handler(
+      config_sym, [this](pmt::pmt_t config) { handle_config(config); });
+}
 
-    virtual void run() override
-    {
-        try {
-            read_packet();
-        } catch (const timeout_error& err) {
-        } catch (const std::exception& ex) {
-            debug(debug_flags::decode, "unhandled exception: %s\n", ex.what());
-        }
-    }
+/*
+ * Our virtual destructor.
+ */
+template <class T>
+decode_impl<T>::~decode_impl()
+{
+}
 
-    virtual void on_exit() override
-    {
-        need_reset = true;
-    }
+template <class T>
+std::vector<std::uint64_t> decode_impl<T>::latency_histogram() const
+{
+    return timer_.histogram();
+}
 
-    bool detect_sync_width()
-    {
-        int detected_width = 0;
-        int wait_time = -1;
-        while (true) {
-            int hi_count = count_until(&is_low, wait_time);
-            int lo_count = count_until(&is_high, wait_time);
-
-            if (detected_width > 1 && lo_count > (1.7 * detected_width)) {
-                debug(
-                  debug_flags::decode, "detected sync %d\n:", detected_width);
-                timing = timing_params { detected_width };
-                return true;
-            }
+template <class T>
+void decode_impl<T>::set_tolerance(double tolerance)
+{
+    update_settings(
+      [tolerance](core::decoder_settings& s) { s.tolerance = tolerance; });
+}
 
-            int total = hi_count + lo_count;
-            if (
-              !within_range(hi_count, total / 2.0, tolerance) ||
-              !within_range(lo_count, total / 2.0, tolerance)) {
-                debug(
-                  debug_flags::decode,
-                  "bad sync: hi(%d) lo(%d) avg(%d)\n",
-                  hi_count,
-                  lo_count,
-                  detected_width);
-                return false;
-            }
+template <class T>
+void decode_impl<T>::set_threshold(double threshold)
+{
+    update_settings(
+      [threshold](core::decoder_settings& s) { s.threshold = threshold; });
+}
 
-            detected_width =
-              (detected_width * sync_count + hi_count) / (sync_count + 1);
-            sync_count += 1;
-            wait_time = detected_width * 4;
-        }
-    }
+template <class T>
+void decode_impl<T>::set_limits(
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count)
+{
+    update_settings([=](core::decoder_settings& s) {
+        s.min_width_us = min_width_us;
+        s.max_width_us = max_width_us;
+        s.min_sync_count = min_sync_count;
+    });
+}
 
-    int receive_bit(bool (*fn)(float), std::vector<bool>& out)
-    {
-        if (out.size() > 1024) {
-            debug(debug_flags::decode, "Exceeded packet bit limit");
-            throw too_many_bits_error{};
-        }
+template <class T>
+void decode_impl<T>::set_expected_bits(
+  const std::vector<int>& expected_bits,
+  bool learn_lengths)
+{
+    update_settings([&](core::decoder_settings& s) {
+        s.expected_bits = expected_bits;
+        s.learn_lengths = learn_lengths;
+    });
+}
 
-        int count = count_until(fn);
-        if (within_range(count, timing.one, tolerance)) {
-            out.push_back(true);
-            return 0;
-        } else if (within_range(count, timing.zero, tolerance)) {
-            out.push_back(false);
-            return 0;
-        }
+template <class T>
+void decode_impl<T>::set_verbose(bool verbose)
+{
+    update_settings(
+      [verbose](core::decoder_settings& s) { s.verbose = verbose; });
+}
 
-        return count;
+template <class T>
+void decode_impl<T>::handle_config(pmt::pmt_t config)
+{
+    if (!pmt::is_dict(config)) {
+        throw std::invalid_argument("decode: config expects a dict");
     }
 
-    void receive_data(std::vector<bool>& out)
-    {
-        while (true) {
-            int lo = receive_bit(&is_high, out);
-
-            if (within_range(lo, timing.preamble, tolerance)) {
-                /* start of a mid-amble */
-                if (!within_range(count_until(&is_low), timing.preamble, tolerance)) {
-                    throw bad_midamble_error { };
-                }
-            } else if (lo > timing.end) {
-                return;
-            } else if (lo != 0) {
-                debug(
-                  debug_flags::decode,
-                  "Signal did not go high when expected.\n");
-                debug(
-                  debug_flags::decode,
-                  "lo(%d) one(%d) zero(%d) bit(%d)\n",
-                  lo,
-                  (int)timing.one,
-                  (int)timing.zero,
-                  out.size());
-                return;
-            }
-
-            int hi = receive_bit(&is_low, out);
-            if (hi != 0) {
-                debug(
-                  debug_flags::decode,
-                  "Signal did not go low when expected.\n");
-                debug(
-                  debug_flags::decode,
-                  "hi(%d) lo(%d) one(%d) zero(%d) preamb(%d) bit(%d)\n",
-                  hi,
-                  lo,
-                  (int)timing.one,
-                  (int)timing.zero,
-                  (int)timing.preamble,
-                  out.size());
-            }
-
-            if (lo != 0) {
-                return;
+    update_settings([&config](core::decoder_settings& s) {
+        for (auto items = pmt::dict_items(config); pmt::is_pair(items);
+             items = pmt::cdr(items)) {
+            const auto key = pmt::car(pmt::car(items));
+            const auto value = pmt::cdr(pmt::car(items));
+            if (pmt::eq(key, tolerance_sym)) {
+                s.tolerance = config_number(key, value);
+            } else if (pmt::eq(key, threshold_sym)) {
+                s.threshold = config_number(key, value);
+            } else if (pmt::eq(key, min_width_us_sym)) {
+                s.min_width_us = config_number(key, value);
+            } else if (pmt::eq(key, max_width_us_sym)) {
+                s.max_width_us = config_number(key, value);
+            } else if (pmt::eq(key, min_sync_count_sym)) {
+                s.min_sync_count = (int)std::lround(config_number(key, value));
+            } else if (pmt::eq(key, expected_bits_sym)) {
+                s.expected_bits = config_lengths(value);
+            } else if (pmt::eq(key, learn_lengths_sym)) {
+                s.learn_lengths = config_bool(key, value);
+            } else if (pmt::eq(key, verbose_sym)) {
+                s.verbose = config_bool(key, value);
+            } else {
+                throw std::invalid_argument(
+                  "decode: unknown config key " +
+                  pmt::symbol_to_string(key));
             }
         }
-    }
-
-    void read_packet()
-    {
-        wait_until(&is_high);
-
-        if (!detect_sync_width()) {
-            return;
-        }
-
-        int preamble_size = count_until(is_low);
-        if (!within_range(preamble_size, timing.preamble, tolerance)) {
-            debug(
-              debug_flags::decode,
-              "Bad preamble: %d != %d\n",
-              preamble_size,
-              timing.preamble);
-            return;
-        } else {
-            debug(
-              debug_flags::decode,
-              "preamble: actual(%d) expected(%d)\n",
-              preamble_size,
-              timing.preamble);
-        }
-
-        debug(debug_flags::decode, "begin receive data\n");
-        receive_data(packet_data);
-        debug(debug_flags::decode, "begin receive check\n");
-        receive_data(packet_check);
+    });
+}
 
-        if (packet_data.size() > 0 && packet_check.size() > 0) {
-            produce_packet();
-        }
+template <class T>
+bool decode_impl<T>::stop()
+{
+    decoder_.flush();
+    if (!batch_.empty()) {
+        publish_batch();
     }
+    return true;
+}
 
-    void resume(const float* new_data, int size)
-    {
-        assert(!has_next());
-
-        data = new_data;
-        endptr = data + size;
+template <class T>
+void decode_impl<T>::publish_packet(const core::packet_info& info)
+{
+    const auto arrival = timer_.arrival_of(info.end_sample);
+    auto message = util::packet_to_pmt(core::to_packet(info));
 
-        while (has_next()) {
-            coroutine::resume();
-            if (need_reset) {
-                reset();
-            }
+    if (batch_.enabled()) {
+        if (batch_.add(message, arrival, timer_.arrival_time())) {
+            publish_batch();
         }
+        return;
     }
 
-    bool has_packet()
-    {
-        return packet_queue.size();
-    }
-
-    pmt::pmt_t next_packet()
-    {
-        auto result = packet_queue.front();
-        packet_queue.pop_front();
-        return result;
-    }
-};
-
-decode::sptr decode::make(double tolerance)
-{
-    return gnuradio::get_initial_sptr(new decode_impl(tolerance));
+    auto timing = timer_.published(arrival);
+    this->message_port_pub(
+      packet_sym, timestamps_ ? util::add_timing(message, timing) : message);
 }
 
-/*
- * The private constructor
- */
-decode_impl::decode_impl(double tolerance)
-    : gr::block(
-        "decode",
-        gr::io_signature::make(1, 1, sizeof(float)),
-        gr::io_signature::make(0, 0, 0)),
-      worker_(new worker{tolerance})
+template <class T>
+void decode_impl<T>::publish_batch()
 {
-    message_port_register_out(worker_->packet_sym);
+    this->message_port_pub(packets_sym, batch_.take(timer_, timestamps_));
 }
 
-/*
- * Our virtual destructor.
- */
-decode_impl::~decode_impl()
+template <class T>
+void decode_impl<T>::publish_overload()
 {
+    auto message = pmt::make_dict();
+    message = pmt::dict_add(
+      message, overloaded_sym, pmt::from_bool(load_.overloaded()));
+    message = pmt::dict_add(message, load_sym, pmt::from_double(load_.load()));
+    message = pmt::dict_add(
+      message,
+      missed_deadlines_sym,
+      pmt::from_uint64(load_.missed_deadlines()));
+    message = pmt::dict_add(
+      message, sample_sym, pmt::from_uint64(this->nitems_read(0)));
+    this->message_port_pub(overload_sym, message);
 }
 
-void decode_impl::forecast(
+template <class T>
+void decode_impl<T>::forecast(
   int noutput_items,
   gr_vector_int& ninput_items_required)
 {
 }
 
-int decode_impl::general_work(
+template <class T>
+int decode_impl<T>::general_work(
   int noutput_items,
   gr_vector_int& ninput_items,
   gr_vector_const_void_star& input_items,
   gr_vector_void_star& output_items)
 {
-    worker_->resume((const float*)input_items[0], ninput_items[0]);
+    const int count = ninput_items[0];
+    timer_.arrived(fed_);
+    fed_ += count;
+
+    if (settings_changed_) {
+        std::lock_guard<std::mutex> lock(settings_mutex_);
+        settings_changed_ = false;
+        decoder_.update(requested_);
+    }
+
+    decoder_.feed((const T*)input_items[0], count);
 
-    while (worker_->has_packet()) {
-        auto packet = worker_->next_packet();
-        message_port_pub(worker_->packet_sym, packet);
+    if (batch_.expired(timer_.arrival_time())) {
+        publish_batch();
+    }
+    if (load_.update(
+          timer_.arrival_time(), util::load_monitor::clock::now(), count)) {
+        decoder_.set_degraded(load_.overloaded());
+        publish_overload();
     }
 
     // Tell runtime system how many input items we consumed on
     // each input stream.
-    consume_each(noutput_items);
+    this->consume_each(noutput_items);
 
     // Tell runtime system how many output items we produced.
     return noutput_items;
 }
+
+template class decode_blk<float>;
+template class decode_blk<std::int16_t>;
+template class decode_blk<std::int8_t>;
+
+template class decode_impl<float>;
+template class decode_impl<std::int16_t>;
+template class decode_impl<std::int8_t>;
+
+} /* namespace ook */
+} /* namespace gr */
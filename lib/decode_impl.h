@@ -21,23 +21,94 @@
 #ifndef INCLUDED_OOK_DECODE_IMPL_H
 #define INCLUDED_OOK_DECODE_IMPL_H
 
+#include <ook/core.h>
 #include <ook/decode.h>
-#include <memory>
+#include <atomic>
+#include <mutex>
+
+#include "load_monitor.h"
+#include "packet_batch.h"
+#include "packet_timer.h"
 
 namespace gr
 {
 namespace ook
 {
-class decode_impl : public decode
+template <class T>
+class decode_impl : public decode_blk<T>
 {
   private:
-    struct worker;
-    std::unique_ptr<worker> worker_;
+    /*
+     * Setters and the 'config' port change 'requested_' under the
+     * mutex; the work thread hands a copy to the decoder, which applies
+     * it between packets.
+     */
+    std::mutex settings_mutex_;
+    core::decoder_settings requested_;
+    std::atomic<bool> settings_changed_;
+
+    core::basic_decoder<T> decoder_;
+    util::packet_timer timer_;
+    /* Samples fed so far, to time packets by their last sample. */
+    std::uint64_t fed_ = 0;
+    const bool timestamps_;
+    util::packet_batch batch_;
+    util::load_monitor load_;
+
+    template <class F>
+    void update_settings(F&& change)
+    {
+        std::lock_guard<std::mutex> lock(settings_mutex_);
+        core::decoder_settings next = requested_;
+        change(next);
+        requested_ = std::move(next);
+        settings_changed_ = true;
+    }
+    void handle_config(pmt::pmt_t config);
+
+    void publish_packet(const core::packet_info& info);
+    void publish_batch();
+    void publish_overload();
 
   public:
-    decode_impl(double tolerance = 0.1);
+    decode_impl(
+      double tolerance,
+      double threshold,
+      bool timestamps,
+      const std::vector<int>& expected_bits,
+      bool learn_lengths,
+      double sample_rate,
+      double min_width_us,
+      double max_width_us,
+      int min_sync_count,
+      int batch_size,
+      double batch_timeout_ms,
+      double max_load,
+      bool levels,
+      bool interpolate,
+      double squelch,
+      const std::string& record_prefix,
+      int record_ring,
+      int record_files,
+      double record_kb_per_s,
+      double sync_correlation);
     ~decode_impl();
 
+    std::vector<std::uint64_t> latency_histogram() const;
+
+    void set_tolerance(double tolerance);
+    void set_threshold(double threshold);
+    void set_limits(
+      double min_width_us,
+      double max_width_us,
+      int min_sync_count);
+    void set_expected_bits(
+      const std::vector<int>& expected_bits,
+      bool learn_lengths);
+    void set_verbose(bool verbose);
+
+    bool stop();
+
     // Where all the action really happens
     void forecast(int noutput_items, gr_vector_int& ninput_items_required);
 
@@ -0,0 +1,81 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+
+#include "edge_detector_impl.h"
+
+namespace gr
+{
+namespace ook
+{
+edge_detector::sptr edge_detector::make(double threshold)
+{
+    return gnuradio::get_initial_sptr(new edge_detector_impl(threshold));
+}
+
+/*
+ * The private constructor
+ */
+edge_detector_impl::edge_detector_impl(double threshold)
+    : gr::block(
+        "edge_detector",
+        gr::io_signature::make(1, 1, sizeof(float)),
+        gr::io_signature::make(1, 1, sizeof(run_t))),
+      slicer_((float)threshold)
+{
+}
+
+/*
+ * Our virtual destructor.
+ */
+edge_detector_impl::~edge_detector_impl()
+{
+}
+
+void edge_detector_impl::forecast(
+  int noutput_items,
+  gr_vector_int& ninput_items_required)
+{
+    /* Every sample may start a new run. */
+    ninput_items_required[0] = noutput_items;
+}
+
+int edge_detector_impl::general_work(
+  int noutput_items,
+  gr_vector_int& ninput_items,
+  gr_vector_const_void_star& input_items,
+  gr_vector_void_star& output_items)
+{
+    const int count = std::min(ninput_items[0], noutput_items);
+    int nruns = slicer_.slice(
+      (const float*)input_items[0], count, (run_t*)output_items[0]);
+
+    consume_each(count);
+    return nruns;
+}
+
+} /* namespace ook */
+} /* namespace gr */
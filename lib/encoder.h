@@ -0,0 +1,107 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_ENCODER_H
+#define INCLUDED_OOK_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Describes the waveform of one OOK transmission as a sequence of
+ * constant-level runs: 40 sync pulses, the preamble, the data, the
+ * midamble and the check copy of the data. A sync pulse is 1 ms wide;
+ * a one bit is 1 ms and a zero bit half that, with consecutive bits at
+ * alternating levels.
+ */
+class encoder
+{
+  private:
+    const int ms;
+
+  public:
+    explicit encoder(int sample_rate) : ms(sample_rate / 1000) {}
+
+    /* Call 'emit(count, level)' for each run of the transmission. */
+    template <class Emit>
+    void transmit(const uint8_t* data, size_t size, Emit&& emit) const
+    {
+        sync(emit);
+        preamble(emit);
+        bytes(data, size, emit);
+        preamble(emit);
+        bytes(data, size, emit);
+    }
+
+    /* The length of the transmission of 'data', in samples. */
+    size_t length(const uint8_t* data, size_t size) const
+    {
+        size_t result = 0;
+        transmit(data, size, [&result](int n, float) { result += n; });
+        return result;
+    }
+
+    /* The longest transmission possible for 'size' bytes. */
+    size_t max_length(size_t size) const
+    {
+        return (size_t)(40 * 2 + 1 + 2 * 4) * ms + 2 * 8 * size * ms;
+    }
+
+  private:
+    template <class Emit>
+    void sync(Emit& emit) const
+    {
+        for (int i = 0; i < 40; ++i) {
+            emit(ms, 1.0f);
+            emit(ms, 0.0f);
+        }
+        emit(ms, 1.0f);
+    }
+
+    template <class Emit>
+    void preamble(Emit& emit) const
+    {
+        emit(2 * ms, 0.0f);
+        emit(2 * ms, 1.0f);
+    }
+
+    template <class Emit>
+    void bytes(const uint8_t* data, size_t size, Emit& emit) const
+    {
+        for (size_t i = 0; i < size; ++i) {
+            for (int bit = 0; bit < 8; ++bit) {
+                bool one = (data[i] >> (7 - bit)) & 1;
+                emit(one ? ms : ms / 2, (bit & 1) ? 1.0f : 0.0f);
+            }
+        }
+    }
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_ENCODER_H */
@@ -0,0 +1,97 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "fft.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+fft::fft(size_t size) : n(size), twiddles(size / 2), reversed(size)
+{
+    if (n < 2 || (n & (n - 1))) {
+        throw std::invalid_argument("fft size must be a power of two");
+    }
+
+    for (size_t i = 0; i < n / 2; ++i) {
+        twiddles[i] = std::polar(1.0, -2 * M_PI * i / n);
+    }
+
+    int bits = 0;
+    while (((size_t)1 << bits) < n) {
+        bits++;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = 0;
+        for (int b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        reversed[i] = r;
+    }
+}
+
+void fft::forward(complex* data) const
+{
+    transform(data, false);
+}
+
+void fft::inverse(complex* data) const
+{
+    transform(data, true);
+
+    const float scale = 1.0f / n;
+    for (size_t i = 0; i < n; ++i) {
+        data[i] *= scale;
+    }
+}
+
+void fft::transform(complex* data, bool inverse) const
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (i < reversed[i]) {
+            std::swap(data[i], data[reversed[i]]);
+        }
+    }
+
+    for (size_t half = 1; half < n; half *= 2) {
+        const size_t stride = n / (2 * half);
+        for (size_t start = 0; start < n; start += 2 * half) {
+            for (size_t k = 0; k < half; ++k) {
+                const complex w = twiddles[k * stride];
+                const complex x = data[start + k + half];
+                const float wi = inverse ? -w.imag() : w.imag();
+                /* Spelled out; operator* is slowed by its NaN checks. */
+                const complex odd(
+                  w.real() * x.real() - wi * x.imag(),
+                  w.real() * x.imag() + wi * x.real());
+                data[start + k + half] = data[start + k] - odd;
+                data[start + k] += odd;
+            }
+        }
+    }
+}
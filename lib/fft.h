@@ -0,0 +1,66 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_FFT_H
+#define INCLUDED_OOK_FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * An in-place radix-2 FFT of a fixed power-of-two size, with the
+ * twiddle factors and bit-reversal permutation computed up front. The
+ * inverse is scaled by 1/size, so inverse(forward(x)) == x.
+ */
+class fft
+{
+  public:
+    typedef std::complex<float> complex;
+
+    explicit fft(size_t size);
+
+    size_t size() const
+    {
+        return n;
+    }
+
+    void forward(complex* data) const;
+    void inverse(complex* data) const;
+
+  private:
+    const size_t n;
+    std::vector<complex> twiddles;
+    std::vector<size_t> reversed;
+
+    void transform(complex* data, bool inverse) const;
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_FFT_H */
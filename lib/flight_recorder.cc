@@ -0,0 +1,175 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "flight_recorder.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+constexpr size_t flight_recorder::max_queued;
+
+flight_recorder::flight_recorder(
+  const std::string& prefix_,
+  int files_,
+  double budget_bytes)
+    : prefix(prefix_),
+      files(files_),
+      budget(budget_bytes),
+      tokens(budget_bytes),
+      refilled(std::chrono::steady_clock::now())
+{
+    if (files < 1) {
+        throw std::invalid_argument("flight_recorder needs at least one file");
+    }
+    thread = std::thread([this] { run(); });
+}
+
+flight_recorder::~flight_recorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+bool flight_recorder::admit(size_t samples)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed =
+      std::chrono::duration<double>(now - refilled).count();
+    tokens = std::min(budget, tokens + elapsed * budget);
+    refilled = now;
+
+    const double bytes = samples * sizeof(float);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bytes > tokens || queue.size() >= max_queued) {
+        dropped_++;
+        return false;
+    }
+
+    tokens -= bytes;
+    return true;
+}
+
+void flight_recorder::record(
+  std::vector<float>&& samples,
+  uint64_t start_sample,
+  uint64_t sync_sample,
+  uint64_t failed_sample,
+  const char* reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({ std::move(samples),
+                          start_sample,
+                          sync_sample,
+                          failed_sample,
+                          reason,
+                          dropped_ });
+    }
+    wake.notify_one();
+}
+
+void flight_recorder::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+uint64_t flight_recorder::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped_;
+}
+
+void flight_recorder::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+
+        window w = std::move(queue.front());
+        queue.pop_front();
+        const uint64_t slot = next_slot++ % files;
+
+        writing = true;
+        lock.unlock();
+        write(w, slot);
+        lock.lock();
+        writing = false;
+        done.notify_all();
+    }
+}
+
+void flight_recorder::write(const window& w, uint64_t slot)
+{
+    const std::string base = prefix + "." + std::to_string(slot);
+
+    /* Remove the old sidecar first, so a half-written slot is obvious. */
+    std::remove((base + ".json").c_str());
+
+    FILE* f = std::fopen((base + ".f32").c_str(), "wb");
+    bool ok = f &&
+      std::fwrite(w.samples.data(), sizeof(float), w.samples.size(), f) ==
+        w.samples.size();
+    if (f && std::fclose(f) != 0) {
+        ok = false;
+    }
+
+    FILE* sidecar = ok ? std::fopen((base + ".json").c_str(), "w") : nullptr;
+    if (sidecar) {
+        std::fprintf(
+          sidecar,
+          "{\"reason\": \"%s\", \"start_sample\": %" PRIu64
+          ", \"sync_sample\": %" PRIu64 ", \"failed_sample\": %" PRIu64
+          ", \"samples\": %zu, \"dropped\": %" PRIu64 "}\n",
+          w.reason,
+          w.start_sample,
+          w.sync_sample,
+          w.failed_sample,
+          w.samples.size(),
+          w.dropped);
+        ok = std::fclose(sidecar) == 0;
+    }
+
+    if (!ok) {
+        std::fprintf(
+          stderr,
+          "flight_recorder: cannot write %s: %s\n",
+          base.c_str(),
+          std::strerror(errno));
+    }
+}
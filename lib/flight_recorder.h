@@ -0,0 +1,171 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_FLIGHT_RECORDER_H
+#define INCLUDED_OOK_FLIGHT_RECORDER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * The most recent 'size' samples of a stream, by absolute index.
+ */
+template <class T>
+class sample_ring
+{
+  public:
+    explicit sample_ring(size_t size) : samples(size) {}
+
+    void push(const T* in, size_t n)
+    {
+        const size_t size = samples.size();
+        if (n > size) {
+            in += n - size;
+            end += n - size;
+            n = size;
+        }
+
+        const size_t at = end % size;
+        const size_t first = std::min(n, size - at);
+        std::copy(in, in + first, samples.begin() + at);
+        std::copy(in + first, in + n, samples.begin());
+        end += n;
+    }
+
+    /* The index of the oldest sample still held. */
+    uint64_t begin() const
+    {
+        return end > samples.size() ? end - samples.size() : 0;
+    }
+
+    /*
+     * Copy samples [start, stop), which must be held, to 'out', divided
+     * by 'scale'.
+     */
+    void copy(uint64_t start, uint64_t stop, float* out, double scale) const
+    {
+        const size_t size = samples.size();
+        for (uint64_t i = start; i < stop; ++i) {
+            *out++ = (float)(samples[i % size] / scale);
+        }
+    }
+
+  private:
+    std::vector<T> samples;
+    uint64_t end = 0;
+};
+
+/*
+ * Writes windows of samples around failed decodes to a rotating set of
+ * files, '<prefix>.<slot>.f32' with a '<prefix>.<slot>.json' sidecar
+ * giving the reason, the positions and the number of windows dropped
+ * so far. The slot counts up modulo 'files', so the oldest window is
+ * overwritten first.
+ *
+ * Files are written by a background thread. record() only takes a
+ * short lock to queue the window, and drops it instead if the queue is
+ * full or the window would exceed the I/O budget: a bucket of
+ * 'budget_bytes' per second of wall-clock time, holding at most one
+ * second's worth, so larger windows are never written.
+ */
+class flight_recorder
+{
+  public:
+    flight_recorder(const std::string& prefix, int files, double budget_bytes);
+    ~flight_recorder();
+
+    flight_recorder(const flight_recorder&) = delete;
+    flight_recorder& operator=(const flight_recorder&) = delete;
+
+    /*
+     * Whether a window of 'samples' samples fits the budget now. If it
+     * does, the caller should pass it to record() straight away.
+     */
+    bool admit(size_t samples);
+
+    /*
+     * Queue a window admitted by admit(), whose first sample is at
+     * 'start_sample', for an attempt that began at 'sync_sample' and
+     * failed at 'failed_sample'.
+     */
+    void record(
+      std::vector<float>&& samples,
+      uint64_t start_sample,
+      uint64_t sync_sample,
+      uint64_t failed_sample,
+      const char* reason);
+
+    /* Wait until every queued window has been written. */
+    void flush();
+
+    /* Windows dropped so far, for the budget or a full queue. */
+    uint64_t dropped() const;
+
+  private:
+    struct window {
+        std::vector<float> samples;
+        uint64_t start_sample;
+        uint64_t sync_sample;
+        uint64_t failed_sample;
+        const char* reason;
+        uint64_t dropped;
+    };
+
+    static constexpr size_t max_queued = 4;
+
+    const std::string prefix;
+    const int files;
+    const double budget;
+
+    double tokens;
+    std::chrono::steady_clock::time_point refilled;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::deque<window> queue;
+    bool writing = false;
+    uint64_t dropped_ = 0;
+    uint64_t next_slot = 0;
+    bool stopping = false;
+    std::thread thread;
+
+    void write(const window& w, uint64_t slot);
+    void run();
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_FLIGHT_RECORDER_H */
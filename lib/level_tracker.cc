@@ -0,0 +1,103 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include "level_tracker.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+const double max_snr_db = 120;
+}
+
+level_tracker::level_tracker(double full_scale) : scale(full_scale)
+{
+}
+
+void level_tracker::add(const run_t* runs, const run_sums* sums, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        entry e;
+        e.start = position;
+        e.length = run_duration(runs[i]);
+        e.level = run_level(runs[i]);
+        e.measured = sums != nullptr;
+        e.sums = sums ? sums[i] : run_sums{ 0, 0 };
+        position += e.length;
+        history.push_back(e);
+    }
+
+    while (history.size() > max_runs) {
+        history.pop_front();
+    }
+}
+
+void level_tracker::measure(packet& p) const
+{
+    double count[2] = { 0, 0 };
+    double sum[2] = { 0, 0 };
+    double squares[2] = { 0, 0 };
+
+    const double first = p.start_sample;
+    const double last = p.end_sample + 1;
+    for (auto it = history.rbegin(); it != history.rend(); ++it) {
+        const double end = it->start + it->length;
+        if (end <= first) {
+            break;
+        }
+        if (it->start >= last || !it->measured) {
+            continue;
+        }
+
+        const double overlap =
+          std::min(end, last) - std::max(it->start, first);
+        const double share = overlap / it->length;
+        count[it->level] += overlap;
+        sum[it->level] += it->sums.sum * share;
+        squares[it->level] += it->sums.squares * share;
+    }
+
+    if (!count[0] || !count[1]) {
+        return;
+    }
+
+    const double high = sum[1] / count[1];
+    const double low = sum[0] / count[0];
+    const double spread = squares[1] - count[1] * high * high + squares[0] -
+                          count[0] * low * low;
+    const double variance = std::max(spread, 0.0) / (count[0] + count[1]);
+    const double separation = (high - low) * (high - low);
+
+    p.has_levels = true;
+    p.rssi = high / scale;
+    p.noise = low / scale;
+    p.snr = variance > separation * std::pow(10, -max_snr_db / 10)
+              ? 10 * std::log10(separation / variance)
+              : max_snr_db;
+}
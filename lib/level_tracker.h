@@ -0,0 +1,80 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_LEVEL_TRACKER_H
+#define INCLUDED_OOK_LEVEL_TRACKER_H
+
+#include <ook/packet.h>
+#include <ook/run.h>
+#include <cstdint>
+#include <deque>
+
+#include "slicer.h"
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Measures the signal levels of decoded packets from the per-run sums
+ * the slicer produces, so that the samples are only read once. The
+ * most recent runs are kept with their positions, and a packet's levels
+ * are taken from the runs between its start and end samples. Runs that
+ * straddle either end count in proportion to their overlap.
+ */
+class level_tracker
+{
+  public:
+    /* The runs kept; more than any packet the reader accepts spans. */
+    static constexpr size_t max_runs = 16384;
+
+    /* 'full_scale' is the sample value that corresponds to 1.0. */
+    explicit level_tracker(double full_scale);
+
+    /*
+     * Record the next 'count' runs. 'sums' may be null if unknown, as for
+     * skipped idle input; such runs are left out of the levels.
+     */
+    void add(const run_t* runs, const run_sums* sums, int count);
+
+    /* Fill in the level fields of 'p' from its sample range. */
+    void measure(packet& p) const;
+
+  private:
+    struct entry {
+        double start;
+        double length;
+        bool level;
+        bool measured;
+        run_sums sums;
+    };
+
+    const double scale;
+    std::deque<entry> history;
+    double position = 0;
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_LEVEL_TRACKER_H */
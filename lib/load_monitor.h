@@ -0,0 +1,131 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_LOAD_MONITOR_H
+#define INCLUDED_OOK_LOAD_MONITOR_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Tracks whether a block keeps up with real time. Each work call has a
+ * deadline of the duration of the samples it was given, at the
+ * configured sample rate. The load is the wall-clock time spent in work
+ * calls divided by the duration of their samples, measured over windows
+ * of 'window' seconds of input.
+ *
+ * The monitor becomes overloaded when a call misses its deadline or a
+ * window's load exceeds 'max_load'. It recovers once a window's load
+ * falls below half of 'max_load'. Calls covering less than
+ * 'min_deadline' seconds are only judged as part of their window. A
+ * sample rate or maximum load of zero disables the monitor.
+ */
+class load_monitor
+{
+  public:
+    typedef std::chrono::steady_clock clock;
+
+    static constexpr double window = 0.1;
+    /* Calls shorter than this are too short to judge on their own. */
+    static constexpr double min_deadline = 1e-3;
+
+    load_monitor(double sample_rate_, double max_load_) :
+        sample_rate(sample_rate_),
+        max_load(max_load_)
+    {
+    }
+
+    bool enabled() const
+    {
+        return sample_rate > 0 && max_load > 0;
+    }
+
+    bool overloaded() const
+    {
+        return overloaded_;
+    }
+
+    /* The load of the last complete window. */
+    double load() const
+    {
+        return load_;
+    }
+
+    /* Calls that took longer than their samples last, in total. */
+    uint64_t missed_deadlines() const
+    {
+        return missed;
+    }
+
+    /*
+     * Account for a work call that ran from 'start' to 'end' on 'samples'
+     * samples. Returns true if the call changed overloaded().
+     */
+    bool update(clock::time_point start, clock::time_point end, int samples)
+    {
+        if (!enabled() || samples <= 0) {
+            return false;
+        }
+
+        const double busy = std::chrono::duration<double>(end - start).count();
+        const double duration = samples / sample_rate;
+        window_busy += busy;
+        window_duration += duration;
+
+        const bool was_overloaded = overloaded_;
+        if (duration >= min_deadline && busy > duration) {
+            missed++;
+            overloaded_ = true;
+        }
+
+        if (window_duration >= window) {
+            load_ = window_busy / window_duration;
+            window_busy = window_duration = 0;
+            if (load_ > max_load) {
+                overloaded_ = true;
+            } else if (load_ < max_load / 2) {
+                overloaded_ = false;
+            }
+        }
+        return overloaded_ != was_overloaded;
+    }
+
+  private:
+    const double sample_rate;
+    const double max_load;
+
+    bool overloaded_ = false;
+    double load_ = 0;
+    uint64_t missed = 0;
+    double window_busy = 0;
+    double window_duration = 0;
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_LOAD_MONITOR_H */
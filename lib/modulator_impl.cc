@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+
+#include "modulator_impl.h"
+
+namespace gr
+{
+namespace ook
+{
+modulator::sptr modulator::make(
+  int sample_rate,
+  int gap_ms,
+  const std::string& len_tag_key)
+{
+    return gnuradio::get_initial_sptr(
+      new modulator_impl(sample_rate, gap_ms, len_tag_key));
+}
+
+/*
+ * The private constructor
+ */
+modulator_impl::modulator_impl(
+  int sample_rate,
+  int gap_ms,
+  const std::string& len_tag_key)
+    : gr::tagged_stream_block(
+        "modulator",
+        gr::io_signature::make(1, 1, sizeof(uint8_t)),
+        gr::io_signature::make(1, 1, sizeof(float)),
+        len_tag_key),
+      encoder_(sample_rate),
+      gap_(gap_ms * (sample_rate / 1000))
+{
+}
+
+/*
+ * Our virtual destructor.
+ */
+modulator_impl::~modulator_impl()
+{
+}
+
+int modulator_impl::calculate_output_stream_length(
+  const gr_vector_int& ninput_items)
+{
+    return (int)encoder_.max_length(ninput_items[0]) + gap_;
+}
+
+int modulator_impl::work(
+  int noutput_items,
+  gr_vector_int& ninput_items,
+  gr_vector_const_void_star& input_items,
+  gr_vector_void_star& output_items)
+{
+    const uint8_t* in = (const uint8_t*)input_items[0];
+    float* const start = (float*)output_items[0];
+    float* out = start;
+
+    encoder_.transmit(in, ninput_items[0], [&out](int n, float level) {
+        out = std::fill_n(out, n, level);
+    });
+    out = std::fill_n(out, gap_, 0.0f);
+
+    return (int)(out - start);
+}
+
+} /* namespace ook */
+} /* namespace gr */
@@ -0,0 +1,200 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <stdexcept>
+
+#include "multi_decode_impl.h"
+#include "packet_pmt.h"
+
+namespace
+{
+const pmt::pmt_t packet_sym = pmt::mp("packet");
+const pmt::pmt_t packets_sym = pmt::mp("packets");
+const pmt::pmt_t channel_sym = pmt::mp("channel");
+
+int checked_channels(int channels)
+{
+    if (channels < 1) {
+        throw std::invalid_argument("multi_decode needs at least 1 channel");
+    }
+    return channels;
+}
+}
+
+namespace gr
+{
+namespace ook
+{
+multi_decode::sptr multi_decode::make(
+  int channels,
+  double tolerance,
+  double threshold,
+  bool timestamps,
+  const std::vector<int>& expected_bits,
+  bool learn_lengths,
+  double sample_rate,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count,
+  int batch_size,
+  double batch_timeout_ms)
+{
+    return gnuradio::get_initial_sptr(new multi_decode_impl(
+      channels,
+      tolerance,
+      threshold,
+      timestamps,
+      expected_bits,
+      learn_lengths,
+      sample_rate,
+      min_width_us,
+      max_width_us,
+      min_sync_count,
+      batch_size,
+      batch_timeout_ms));
+}
+
+/*
+ * The private constructor
+ */
+multi_decode_impl::multi_decode_impl(
+  int channels,
+  double tolerance,
+  double threshold,
+  bool timestamps,
+  const std::vector<int>& expected_bits,
+  bool learn_lengths,
+  double sample_rate,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count,
+  int batch_size,
+  double batch_timeout_ms)
+    : gr::block(
+        "multi_decode",
+        gr::io_signature::make(
+          1, 1, sizeof(float) * checked_channels(channels)),
+        gr::io_signature::make(0, 0, 0)),
+      channels_(channels),
+      slicer_(channels, (float)threshold),
+      timestamps_(timestamps),
+      batch_(batch_size, batch_timeout_ms)
+{
+    for (int c = 0; c < channels_; ++c) {
+        std::unique_ptr<util::packet_reader> reader(
+          new util::packet_reader(tolerance));
+        reader->expect_lengths(expected_bits, learn_lengths);
+        reader->set_limits(
+          sample_rate, min_width_us, max_width_us, min_sync_count);
+        readers_.push_back(std::move(reader));
+    }
+    message_port_register_out(packet_sym);
+    message_port_register_out(packets_sym);
+}
+
+/*
+ * Our virtual destructor.
+ */
+multi_decode_impl::~multi_decode_impl()
+{
+}
+
+std::vector<std::uint64_t> multi_decode_impl::latency_histogram() const
+{
+    return timer_.histogram();
+}
+
+bool multi_decode_impl::stop()
+{
+    if (!batch_.empty()) {
+        publish_batch();
+    }
+    return true;
+}
+
+void multi_decode_impl::publish_packets(int channel)
+{
+    auto& reader = *readers_[channel];
+    const auto now = timer_.arrival_time();
+    while (reader.has_packet()) {
+        auto packet = reader.next_packet();
+        auto message = pmt::dict_add(
+          util::packet_to_pmt(packet), channel_sym, pmt::from_long(channel));
+
+        if (batch_.enabled()) {
+            if (batch_.add(message, timer_.arrival(), now)) {
+                publish_batch();
+            }
+            continue;
+        }
+
+        auto timing = timer_.published(timer_.arrival());
+        message_port_pub(
+          packet_sym,
+          timestamps_ ? util::add_timing(message, timing) : message);
+    }
+}
+
+void multi_decode_impl::publish_batch()
+{
+    message_port_pub(packets_sym, batch_.take(timer_, timestamps_));
+}
+
+void multi_decode_impl::forecast(
+  int noutput_items,
+  gr_vector_int& ninput_items_required)
+{
+}
+
+int multi_decode_impl::general_work(
+  int noutput_items,
+  gr_vector_int& ninput_items,
+  gr_vector_const_void_star& input_items,
+  gr_vector_void_star& output_items)
+{
+    /* Nothing is held back, so packets are timed from this call. */
+    timer_.arrived(nitems_read(0));
+
+    const int count = ninput_items[0];
+    slicer_.slice((const float*)input_items[0], count);
+    for (int c = 0; c < channels_; ++c) {
+        readers_[c]->resume(slicer_.runs(c), slicer_.run_count(c));
+        publish_packets(c);
+    }
+
+    if (batch_.expired(timer_.arrival_time())) {
+        publish_batch();
+    }
+
+    // Tell runtime system how many input items we consumed on
+    // each input stream.
+    consume_each(noutput_items);
+
+    // Tell runtime system how many output items we produced.
+    return noutput_items;
+}
+
+} /* namespace ook */
+} /* namespace gr */
@@ -0,0 +1,83 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_MULTI_DECODE_IMPL_H
+#define INCLUDED_OOK_MULTI_DECODE_IMPL_H
+
+#include <ook/multi_decode.h>
+#include <memory>
+#include <vector>
+
+#include "multi_slicer.h"
+#include "packet_batch.h"
+#include "packet_reader.h"
+#include "packet_timer.h"
+
+namespace gr
+{
+namespace ook
+{
+class multi_decode_impl : public multi_decode
+{
+  private:
+    const int channels_;
+    util::multi_slicer slicer_;
+    std::vector<std::unique_ptr<util::packet_reader>> readers_;
+    util::packet_timer timer_;
+    const bool timestamps_;
+    util::packet_batch batch_;
+
+    void publish_packets(int channel);
+    void publish_batch();
+
+  public:
+    multi_decode_impl(
+      int channels,
+      double tolerance,
+      double threshold,
+      bool timestamps,
+      const std::vector<int>& expected_bits,
+      bool learn_lengths,
+      double sample_rate,
+      double min_width_us,
+      double max_width_us,
+      int min_sync_count,
+      int batch_size,
+      double batch_timeout_ms);
+    ~multi_decode_impl();
+
+    std::vector<std::uint64_t> latency_histogram() const;
+
+    bool stop();
+
+    // Where all the action really happens
+    void forecast(int noutput_items, gr_vector_int& ninput_items_required);
+
+    int general_work(
+      int noutput_items,
+      gr_vector_int& ninput_items,
+      gr_vector_const_void_star& input_items,
+      gr_vector_void_star& output_items);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_MULTI_DECODE_IMPL_H */
@@ -0,0 +1,189 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "multi_slicer.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+/*
+ * Compare one register of channels against the threshold, returning a
+ * bit per lane for samples above it in 'above' and below it in 'below'.
+ * The widest instruction set enabled at build time is used.
+ */
+#if defined(__AVX512F__)
+const int lane_count = 16;
+
+inline void compare(
+  const float* in,
+  float threshold,
+  unsigned& above,
+  unsigned& below)
+{
+    const __m512 x = _mm512_loadu_ps(in);
+    const __m512 t = _mm512_set1_ps(threshold);
+    above = _mm512_cmp_ps_mask(x, t, _CMP_GT_OQ);
+    below = _mm512_cmp_ps_mask(x, t, _CMP_LT_OQ);
+}
+#elif defined(__AVX__)
+const int lane_count = 8;
+
+inline void compare(
+  const float* in,
+  float threshold,
+  unsigned& above,
+  unsigned& below)
+{
+    const __m256 x = _mm256_loadu_ps(in);
+    const __m256 t = _mm256_set1_ps(threshold);
+    above = _mm256_movemask_ps(_mm256_cmp_ps(x, t, _CMP_GT_OQ));
+    below = _mm256_movemask_ps(_mm256_cmp_ps(x, t, _CMP_LT_OQ));
+}
+#elif defined(__SSE2__)
+const int lane_count = 4;
+
+inline void compare(
+  const float* in,
+  float threshold,
+  unsigned& above,
+  unsigned& below)
+{
+    const __m128 x = _mm_loadu_ps(in);
+    const __m128 t = _mm_set1_ps(threshold);
+    above = _mm_movemask_ps(_mm_cmpgt_ps(x, t));
+    below = _mm_movemask_ps(_mm_cmplt_ps(x, t));
+}
+#else
+const int lane_count = 1;
+
+inline void compare(
+  const float* in,
+  float threshold,
+  unsigned& above,
+  unsigned& below)
+{
+    above = *in > threshold;
+    below = *in < threshold;
+}
+#endif
+
+/* The same comparison for a partial register at the end of a frame. */
+inline void compare_partial(
+  const float* in,
+  int n,
+  float threshold,
+  unsigned& above,
+  unsigned& below)
+{
+    above = below = 0;
+    for (int i = 0; i < n; ++i) {
+        above |= (unsigned)(in[i] > threshold) << i;
+        below |= (unsigned)(in[i] < threshold) << i;
+    }
+}
+}
+
+int multi_slicer::lanes()
+{
+    return lane_count;
+}
+
+multi_slicer::multi_slicer(int channels_, float threshold_)
+    : channels(channels_),
+      threshold(threshold_),
+      levels((channels_ + lane_count - 1) / lane_count),
+      run_start(channels_),
+      counts(channels_)
+{
+}
+
+void multi_slicer::edges(int group, unsigned changed, int sample)
+{
+    const unsigned level = levels[group];
+    do {
+        const int lane = __builtin_ctz(changed);
+        const int channel = group * lane_count + lane;
+        changed &= changed - 1;
+
+        const int length = sample - run_start[channel];
+        if (length) {
+            runs_[(size_t)channel * stride + counts[channel]++] =
+              make_run((level >> lane) & 1, length);
+        }
+        run_start[channel] = sample;
+    } while (changed);
+}
+
+void multi_slicer::slice(const float* in, int n)
+{
+    if (stride < n) {
+        stride = n;
+        runs_.resize((size_t)channels * stride);
+    }
+    for (int c = 0; c < channels; ++c) {
+        run_start[c] = 0;
+        counts[c] = 0;
+    }
+
+    const int full = channels / lane_count;
+    const int rest = channels % lane_count;
+    for (int i = 0; i < n; ++i) {
+        const float* frame = in + (size_t)i * channels;
+        unsigned above, below;
+        for (int g = 0; g < full; ++g) {
+            compare(frame + g * lane_count, threshold, above, below);
+            const unsigned next = above | (levels[g] & ~below);
+            if (next != levels[g]) {
+                edges(g, next ^ levels[g], i);
+                levels[g] = next;
+            }
+        }
+
+        if (rest) {
+            compare_partial(
+              frame + full * lane_count, rest, threshold, above, below);
+            const unsigned next = above | (levels[full] & ~below);
+            if (next != levels[full]) {
+                edges(full, next ^ levels[full], i);
+                levels[full] = next;
+            }
+        }
+    }
+
+    for (int c = 0; c < channels; ++c) {
+        const int length = n - run_start[c];
+        if (length) {
+            const unsigned level = levels[c / lane_count];
+            runs_[(size_t)c * stride + counts[c]++] =
+              make_run((level >> (c % lane_count)) & 1, length);
+        }
+    }
+}
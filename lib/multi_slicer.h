@@ -0,0 +1,82 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_MULTI_SLICER_H
+#define INCLUDED_OOK_MULTI_SLICER_H
+
+#include <ook/run.h>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Slices several interleaved envelopes at once. Sample i of channel c is
+ * in[i * channels + c]. Each channel is sliced as util::slicer would
+ * slice it on its own, including the flush at the end of every call.
+ *
+ * Channels are compared against the threshold a SIMD register at a time
+ * and each register's levels are kept as a bit mask, so a sample frame
+ * with no edges costs one compare per register. Runs are only written
+ * for the lanes whose bit changed.
+ */
+class multi_slicer
+{
+  private:
+    const int channels;
+    const float threshold;
+
+    std::vector<unsigned> levels;  /* one bit per channel, per group */
+    std::vector<int> run_start;    /* per channel, within this call */
+    std::vector<int> counts;       /* runs written, per channel */
+    std::vector<run_t> runs_;      /* 'stride' runs per channel */
+    int stride = 0;
+
+    void edges(int group, unsigned changed, int sample);
+
+  public:
+    /* The number of channels compared per instruction. */
+    static int lanes();
+
+    multi_slicer(int channels, float threshold);
+
+    /* Slice 'n' frames of 'channels' samples each. */
+    void slice(const float* in, int n);
+
+    /* The runs from the last call to slice() for one channel. */
+    const run_t* runs(int channel) const
+    {
+        return runs_.data() + (size_t)channel * stride;
+    }
+
+    int run_count(int channel) const
+    {
+        return counts[channel];
+    }
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_MULTI_SLICER_H */
@@ -0,0 +1,193 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "nco.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+const double accumulator_range = 4294967296.0;
+
+/* Radians per unit of the phase accumulator. */
+const double radians = 2 * M_PI / accumulator_range;
+
+uint32_t phase_step(double frequency, double sample_rate)
+{
+    const double cycles = frequency / sample_rate;
+    return (uint32_t)(uint64_t)std::llround(
+      (cycles - std::floor(cycles)) * accumulator_range);
+}
+
+/* Round 'n' floats in [-1, 1] to the full range of T. */
+template <class T>
+void quantize_scalar(const float* in, int n, T* out)
+{
+    const float scale = std::numeric_limits<T>::max();
+    for (int i = 0; i < n; ++i) {
+        out[i] = (T)std::lrint(in[i] * scale);
+    }
+}
+
+void quantize(const float* in, int n, int16_t* out)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(std::numeric_limits<int16_t>::max());
+    for (; i + 8 <= n; i += 8) {
+        const __m128i a =
+          _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), scale));
+        const __m128i b =
+          _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+    }
+#endif
+    quantize_scalar(in + i, n - i, out + i);
+}
+
+void quantize(const float* in, int n, int8_t* out)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(std::numeric_limits<int8_t>::max());
+    for (; i + 16 <= n; i += 16) {
+        __m128i words[2];
+        for (int half = 0; half < 2; ++half) {
+            const float* x = in + i + 8 * half;
+            const __m128i a =
+              _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(x), scale));
+            const __m128i b =
+              _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(x + 4), scale));
+            words[half] = _mm_packs_epi32(a, b);
+        }
+        _mm_storeu_si128(
+          (__m128i*)(out + i), _mm_packs_epi16(words[0], words[1]));
+    }
+#endif
+    quantize_scalar(in + i, n - i, out + i);
+}
+}
+
+constexpr int nco::block;
+
+nco::nco(double frequency, double sample_rate, float amplitude) :
+    amplitude(amplitude),
+    phase(0),
+    step(phase_step(frequency, sample_rate))
+{
+    for (int k = 0; k < block; ++k) {
+        const double angle = (double)(uint32_t)(step * (uint32_t)k) * radians;
+        rotation_re[k] = std::cos(angle);
+        rotation_im[k] = std::sin(angle);
+    }
+}
+
+void nco::rotate(const float* envelope, int n, float* out)
+{
+    const double angle = phase * radians;
+    const float base_re = amplitude * std::cos(angle);
+    const float base_im = amplitude * std::sin(angle);
+    phase += step * (uint32_t)n;
+
+    int k = 0;
+    if (n == block) {
+#if defined(__AVX__)
+        const __m256 br = _mm256_set1_ps(base_re);
+        const __m256 bi = _mm256_set1_ps(base_im);
+        for (; k < block; k += 8) {
+            const __m256 rr = _mm256_loadu_ps(rotation_re + k);
+            const __m256 ri = _mm256_loadu_ps(rotation_im + k);
+            const __m256 e = _mm256_loadu_ps(envelope + k);
+            const __m256 re = _mm256_mul_ps(
+              e, _mm256_sub_ps(_mm256_mul_ps(br, rr), _mm256_mul_ps(bi, ri)));
+            const __m256 im = _mm256_mul_ps(
+              e, _mm256_add_ps(_mm256_mul_ps(br, ri), _mm256_mul_ps(bi, rr)));
+            const __m256 lo = _mm256_unpacklo_ps(re, im);
+            const __m256 hi = _mm256_unpackhi_ps(re, im);
+            _mm256_storeu_ps(
+              out + 2 * k, _mm256_permute2f128_ps(lo, hi, 0x20));
+            _mm256_storeu_ps(
+              out + 2 * k + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+        }
+#elif defined(__SSE2__)
+        const __m128 br = _mm_set1_ps(base_re);
+        const __m128 bi = _mm_set1_ps(base_im);
+        for (; k < block; k += 4) {
+            const __m128 rr = _mm_loadu_ps(rotation_re + k);
+            const __m128 ri = _mm_loadu_ps(rotation_im + k);
+            const __m128 e = _mm_loadu_ps(envelope + k);
+            const __m128 re = _mm_mul_ps(
+              e, _mm_sub_ps(_mm_mul_ps(br, rr), _mm_mul_ps(bi, ri)));
+            const __m128 im = _mm_mul_ps(
+              e, _mm_add_ps(_mm_mul_ps(br, ri), _mm_mul_ps(bi, rr)));
+            _mm_storeu_ps(out + 2 * k, _mm_unpacklo_ps(re, im));
+            _mm_storeu_ps(out + 2 * k + 4, _mm_unpackhi_ps(re, im));
+        }
+#endif
+    }
+
+    for (; k < n; ++k) {
+        const float re = base_re * rotation_re[k] - base_im * rotation_im[k];
+        const float im = base_re * rotation_im[k] + base_im * rotation_re[k];
+        out[2 * k] = envelope[k] * re;
+        out[2 * k + 1] = envelope[k] * im;
+    }
+}
+
+void nco::mix(const float* envelope, int n, std::complex<float>* out)
+{
+    for (int i = 0; i < n; i += block) {
+        rotate(envelope + i, std::min(block, n - i), (float*)(out + i));
+    }
+}
+
+void nco::mix(const float* envelope, int n, std::complex<int16_t>* out)
+{
+    float samples[2 * block];
+    for (int i = 0; i < n; i += block) {
+        const int count = std::min(block, n - i);
+        rotate(envelope + i, count, samples);
+        quantize(samples, 2 * count, (int16_t*)(out + i));
+    }
+}
+
+void nco::mix(const float* envelope, int n, std::complex<int8_t>* out)
+{
+    float samples[2 * block];
+    for (int i = 0; i < n; i += block) {
+        const int count = std::min(block, n - i);
+        rotate(envelope + i, count, samples);
+        quantize(samples, 2 * count, (int8_t*)(out + i));
+    }
+}
@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_NCO_H
+#define INCLUDED_OOK_NCO_H
+
+#include <complex>
+#include <cstdint>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * A numerically controlled oscillator that keys a carrier with an
+ * envelope. The phase is a 32-bit accumulator, so the frequency is exact
+ * to rate / 2^32 and the phase never drifts. Samples are produced in
+ * blocks: each block starts from the exact phasor of the accumulator and
+ * rotates it by a table of the first 'block' steps, which vectorizes
+ * with the widest instruction set enabled at build time.
+ *
+ * Integer outputs are interleaved I/Q scaled to the full range of the
+ * type, with 'amplitude' 1.0 at full scale.
+ */
+class nco
+{
+  public:
+    static constexpr int block = 16;
+
+    nco(double frequency, double sample_rate, float amplitude);
+
+    /* Write amplitude * envelope[i] * e^(j phase) for 'n' samples. */
+    void mix(const float* envelope, int n, std::complex<float>* out);
+    void mix(const float* envelope, int n, std::complex<int16_t>* out);
+    void mix(const float* envelope, int n, std::complex<int8_t>* out);
+
+  private:
+    const float amplitude;
+    uint32_t phase;
+    const uint32_t step;
+    /* e^(j step k) for k < block. */
+    float rotation_re[block];
+    float rotation_im[block];
+
+    /* As mix, into interleaved floats, for up to 'block' samples. */
+    void rotate(const float* envelope, int n, float* out);
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_NCO_H */
@@ -0,0 +1,125 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_BATCH_H
+#define INCLUDED_OOK_PACKET_BATCH_H
+
+#include <pmt/pmt.h>
+#include <chrono>
+#include <vector>
+
+#include "packet_pmt.h"
+#include "packet_timer.h"
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Collects packet dictionaries so a block can publish them as one PMT
+ * vector instead of one message each. A batch is due once it holds
+ * 'threshold' packets or its oldest packet has waited 'timeout'. The
+ * blocks only run when samples arrive, so the timeout is checked then;
+ * on a stalled stream a partial batch waits for the next input or for
+ * the flowgraph to stop. A threshold of zero disables batching.
+ *
+ * Each packet keeps its arrival, so its latency is recorded when the
+ * batch is taken for publication, time in the batch included.
+ */
+class packet_batch
+{
+  public:
+    typedef std::chrono::steady_clock clock;
+
+    packet_batch(int threshold_, double timeout_ms) :
+        threshold(threshold_ > 0 ? (size_t)threshold_ : 0),
+        timeout(std::chrono::duration_cast<clock::duration>(
+          std::chrono::duration<double, std::milli>(timeout_ms)))
+    {
+    }
+
+    bool enabled() const
+    {
+        return threshold != 0;
+    }
+
+    bool empty() const
+    {
+        return pending.empty();
+    }
+
+    /* Queue a packet without timestamps; true if the batch is now full. */
+    bool add(
+      const pmt::pmt_t& packet,
+      const packet_arrival& arrival,
+      clock::time_point now)
+    {
+        if (pending.empty()) {
+            oldest = now;
+        }
+        pending.push_back({ packet, arrival });
+        return pending.size() >= threshold;
+    }
+
+    bool expired(clock::time_point now) const
+    {
+        return !pending.empty() && now - oldest >= timeout;
+    }
+
+    /*
+     * The queued packets as a PMT vector, recorded by 'timer' as
+     * published now and, with 'timestamps', given their timestamp
+     * fields. The batch is left empty.
+     */
+    pmt::pmt_t take(packet_timer& timer, bool timestamps)
+    {
+        auto result = pmt::make_vector(pending.size(), pmt::PMT_NIL);
+        for (size_t i = 0; i < pending.size(); ++i) {
+            auto timing = timer.published(pending[i].arrival);
+            pmt::vector_set(
+              result,
+              i,
+              timestamps ? add_timing(pending[i].packet, timing)
+                         : pending[i].packet);
+        }
+        pending.clear();
+        return result;
+    }
+
+  private:
+    struct entry {
+        pmt::pmt_t packet;
+        packet_arrival arrival;
+    };
+
+    const size_t threshold;
+    const clock::duration timeout;
+
+    std::vector<entry> pending;
+    clock::time_point oldest;
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_BATCH_H */
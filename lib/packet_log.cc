@@ -0,0 +1,229 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "packet_log_writer.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+const char magic[8] = {'O', 'O', 'K', 'L', 'O', 'G', 0, 0};
+const uint32_t version = 1;
+
+std::runtime_error io_error(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+size_t record_size(size_t payload_size)
+{
+    return (sizeof(packet_log_record) + payload_size + 7) & ~(size_t)7;
+}
+
+/* Largest payload whose padded record still fits record_size. */
+const size_t max_payload =
+  (UINT16_MAX & ~(size_t)7) - sizeof(packet_log_record);
+}
+
+packet_log_reader::packet_log_reader(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw io_error("cannot open", path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw io_error("cannot stat", path);
+    }
+
+    length_ = st.st_size;
+    if (length_ < sizeof(packet_log_header)) {
+        ::close(fd);
+        throw std::runtime_error("not a packet log: " + path);
+    }
+
+    void* mapping = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw io_error("cannot map", path);
+    }
+    map_ = (const char*)mapping;
+
+    auto header = (const packet_log_header*)map_;
+    if (memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+        header->version != version ||
+        header->header_size + header->used > length_) {
+        munmap((void*)map_, length_);
+        throw std::runtime_error("not a packet log: " + path);
+    }
+
+    used_ = header->used;
+    count_ = header->count;
+}
+
+packet_log_reader::~packet_log_reader()
+{
+    munmap((void*)map_, length_);
+}
+
+packet_log_reader::iterator packet_log_reader::begin() const
+{
+    return iterator(map_ + ((const packet_log_header*)map_)->header_size);
+}
+
+packet_log_reader::iterator packet_log_reader::end() const
+{
+    return iterator(
+      map_ + ((const packet_log_header*)map_)->header_size + used_);
+}
+
+std::uint64_t packet_log_reader::size() const
+{
+    return count_;
+}
+
+packet_log_writer::packet_log_writer(
+  const std::string& prefix_,
+  size_t segment_size_) :
+    prefix(prefix_),
+    segment_size(segment_size_)
+{
+    if (segment_size < sizeof(packet_log_header) + record_size(max_payload)) {
+        throw std::invalid_argument("packet log segment size too small");
+    }
+}
+
+packet_log_writer::~packet_log_writer()
+{
+    close();
+}
+
+void packet_log_writer::open_segment()
+{
+    std::string path;
+    while (true) {
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%06u.ooklog", next_index++);
+        path = prefix + suffix;
+
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0) {
+            break;
+        }
+        if (errno != EEXIST) {
+            throw io_error("cannot create", path);
+        }
+    }
+
+    if (ftruncate(fd, segment_size) != 0) {
+        ::close(fd);
+        fd = -1;
+        throw io_error("cannot allocate", path);
+    }
+
+    void* mapping =
+      mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        throw io_error("cannot map", path);
+    }
+
+    map = (char*)mapping;
+    header = (packet_log_header*)map;
+    memcpy(header->magic, magic, sizeof(magic));
+    header->version = version;
+    header->header_size = sizeof(packet_log_header);
+    header->used = 0;
+    header->count = 0;
+}
+
+void packet_log_writer::close()
+{
+    if (!map) {
+        return;
+    }
+
+    const size_t length = header->header_size + header->used;
+    msync(map, length, MS_ASYNC);
+    munmap(map, segment_size);
+    if (ftruncate(fd, length) != 0) {
+        /* The segment stays preallocated; readers only use 'used'. */
+    }
+    ::close(fd);
+
+    map = nullptr;
+    header = nullptr;
+    fd = -1;
+}
+
+void packet_log_writer::append(
+  uint64_t sample_offset,
+  uint32_t bit_count,
+  int sync_count,
+  bool valid_check,
+  const uint8_t* payload,
+  size_t payload_size)
+{
+    if (payload_size > max_payload) {
+        throw std::invalid_argument("packet too large for packet log");
+    }
+
+    const size_t size = record_size(payload_size);
+    if (map && header->header_size + header->used + size > segment_size) {
+        close();
+    }
+    if (!map) {
+        open_segment();
+    }
+
+    packet_log_record record{};
+    record.sample_offset = sample_offset;
+    record.bit_count = bit_count;
+    record.sync_count = (uint16_t)sync_count;
+    record.valid_check = valid_check;
+    record.payload_size = (uint16_t)payload_size;
+    record.record_size = (uint16_t)size;
+
+    char* out = map + header->header_size + header->used;
+    memcpy(out, &record, sizeof(record));
+    memcpy(out + sizeof(record), payload, payload_size);
+
+    /* Publish the record only once it is complete. */
+    __atomic_store_n(&header->count, header->count + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->used, header->used + size, __ATOMIC_RELEASE);
+}
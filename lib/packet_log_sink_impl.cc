@@ -0,0 +1,120 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <stdexcept>
+
+#include "packet_log_sink_impl.h"
+
+namespace
+{
+const pmt::pmt_t packet_sym = pmt::mp("packet");
+const pmt::pmt_t data_sym = pmt::mp("data");
+const pmt::pmt_t bit_count_sym = pmt::mp("bit_count");
+const pmt::pmt_t sync_count_sym = pmt::mp("sync_count");
+const pmt::pmt_t valid_check_sym = pmt::mp("valid_check");
+const pmt::pmt_t start_sample_sym = pmt::mp("start_sample");
+}
+
+namespace gr
+{
+namespace ook
+{
+packet_log_sink::sptr packet_log_sink::make(
+  const std::string& prefix,
+  int segment_mb)
+{
+    return gnuradio::get_initial_sptr(
+      new packet_log_sink_impl(prefix, segment_mb));
+}
+
+/*
+ * The private constructor
+ */
+packet_log_sink_impl::packet_log_sink_impl(
+  const std::string& prefix,
+  int segment_mb)
+    : gr::block(
+        "packet_log_sink",
+        gr::io_signature::make(0, 0, 0),
+        gr::io_signature::make(0, 0, 0)),
+      writer_(prefix, (size_t)segment_mb << 20)
+{
+    message_port_register_in(packet_sym);
+    set_msg_handler(
+      packet_sym, [this](pmt::pmt_t p) { handle_packet(p); });
+}
+
+/*
+ * Our virtual destructor.
+ */
+packet_log_sink_impl::~packet_log_sink_impl()
+{
+}
+
+bool packet_log_sink_impl::stop()
+{
+    writer_.close();
+    return true;
+}
+
+void packet_log_sink_impl::handle_packet(pmt::pmt_t packet)
+{
+    if (pmt::is_vector(packet)) {
+        for (size_t i = 0; i < pmt::length(packet); ++i) {
+            handle_packet(pmt::vector_ref(packet, i));
+        }
+        return;
+    }
+
+    if (!pmt::is_dict(packet)) {
+        throw std::invalid_argument("packet_log_sink expects packet dicts");
+    }
+
+    auto data = pmt::dict_ref(packet, data_sym, pmt::PMT_NIL);
+    size_t size = 0;
+    const uint8_t* payload = nullptr;
+    if (pmt::is_u8vector(data)) {
+        payload = pmt::u8vector_elements(data, size);
+    }
+
+    auto field = [&packet](const pmt::pmt_t& key) {
+        return pmt::dict_ref(packet, key, pmt::PMT_NIL);
+    };
+    auto start_sample = field(start_sample_sym);
+    auto bit_count = field(bit_count_sym);
+    auto sync_count = field(sync_count_sym);
+    auto valid_check = field(valid_check_sym);
+
+    writer_.append(
+      pmt::is_null(start_sample) ? 0 : pmt::to_uint64(start_sample),
+      pmt::is_null(bit_count) ? size * 8 : pmt::to_uint64(bit_count),
+      pmt::is_null(sync_count) ? 0 : pmt::to_long(sync_count),
+      !pmt::is_null(valid_check) && pmt::to_bool(valid_check),
+      payload,
+      size);
+}
+
+} /* namespace ook */
+} /* namespace gr */
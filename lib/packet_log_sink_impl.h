@@ -0,0 +1,49 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_LOG_SINK_IMPL_H
+#define INCLUDED_OOK_PACKET_LOG_SINK_IMPL_H
+
+#include <ook/packet_log_sink.h>
+
+#include "packet_log_writer.h"
+
+namespace gr
+{
+namespace ook
+{
+class packet_log_sink_impl : public packet_log_sink
+{
+  private:
+    util::packet_log_writer writer_;
+
+    void handle_packet(pmt::pmt_t packet);
+
+  public:
+    packet_log_sink_impl(const std::string& prefix, int segment_mb);
+    ~packet_log_sink_impl();
+
+    bool stop();
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_LOG_SINK_IMPL_H */
@@ -0,0 +1,79 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_LOG_WRITER_H
+#define INCLUDED_OOK_PACKET_LOG_WRITER_H
+
+#include <ook/packet_log.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Appends packet records (see ook/packet_log.h) to a series of segment
+ * files named '<prefix>.<index>.ooklog'. Each segment is preallocated to
+ * 'segment_size' bytes and written through a shared mapping, so adding a
+ * record is a couple of memcpy calls. When a segment is full it is
+ * trimmed to its used length and the next index is opened. Existing
+ * segments are never overwritten.
+ */
+class packet_log_writer
+{
+  public:
+    packet_log_writer(const std::string& prefix, size_t segment_size);
+    ~packet_log_writer();
+
+    packet_log_writer(const packet_log_writer&) = delete;
+    packet_log_writer& operator=(const packet_log_writer&) = delete;
+
+    void append(
+      uint64_t sample_offset,
+      uint32_t bit_count,
+      int sync_count,
+      bool valid_check,
+      const uint8_t* payload,
+      size_t payload_size);
+
+    /* Trim and unmap the current segment. Further appends reopen. */
+    void close();
+
+  private:
+    void open_segment();
+
+    const std::string prefix;
+    const size_t segment_size;
+    unsigned next_index = 0;
+
+    int fd = -1;
+    char* map = nullptr;
+    packet_log_header* header = nullptr;
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_LOG_WRITER_H */
@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "packet_pmt.h"
+
+using namespace gr;
+using namespace gr::ook;
+
+pmt::pmt_t
+gr::ook::util::packet_to_pmt(const packet& p, const packet_timing* timing)
+{
+    auto result = pmt::make_dict();
+    result = dict_add(
+        result, pmt::mp("data"), pmt::init_u8vector(p.data.size(), p.data)
+    );
+    result = dict_add(result, pmt::mp("pretty"), pmt::mp(p.pretty));
+    result = dict_add(result, pmt::mp("phy_pretty"), pmt::mp(p.phy_pretty));
+    result = dict_add(result, pmt::mp("bit_count"), pmt::mp(p.bit_count));
+    result = dict_add(result, pmt::mp("sync_count"), pmt::mp(p.sync_count));
+    result = dict_add(result, pmt::mp("sync_width"), pmt::mp(p.sync_width));
+    if (p.sync_width_us > 0) {
+        result = dict_add(
+            result, pmt::mp("sync_width_us"), pmt::mp(p.sync_width_us)
+        );
+    }
+    result = dict_add(
+        result, pmt::mp("valid_check"), pmt::from_bool(p.valid_check)
+    );
+    result = dict_add(
+        result, pmt::mp("start_sample"), pmt::from_uint64(p.start_sample)
+    );
+    result = dict_add(
+        result, pmt::mp("end_sample"), pmt::from_uint64(p.end_sample)
+    );
+    if (p.has_levels) {
+        result = dict_add(result, pmt::mp("rssi"), pmt::mp(p.rssi));
+        result = dict_add(result, pmt::mp("noise"), pmt::mp(p.noise));
+        result = dict_add(result, pmt::mp("snr"), pmt::mp(p.snr));
+    }
+    if (timing) {
+        result = add_timing(result, *timing);
+    }
+    return result;
+}
+
+pmt::pmt_t gr::ook::util::add_timing(
+    const pmt::pmt_t& packet,
+    const packet_timing& timing)
+{
+    auto result = dict_add(
+        packet, pmt::mp("sample_time"), pmt::mp(timing.sample_time)
+    );
+    return dict_add(
+        result, pmt::mp("publish_time"), pmt::mp(timing.publish_time)
+    );
+}
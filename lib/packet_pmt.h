@@ -0,0 +1,49 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_PMT_H
+#define INCLUDED_OOK_PACKET_PMT_H
+
+#include <ook/packet.h>
+#include <pmt/pmt.h>
+
+#include "packet_timer.h"
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Convert a packet into the dictionary published on 'packet' ports.
+ * The timestamp fields are added only if 'timing' is given.
+ */
+pmt::pmt_t
+packet_to_pmt(const packet& p, const packet_timing* timing = nullptr);
+
+/* Add the timestamp fields to a packet dictionary. */
+pmt::pmt_t add_timing(const pmt::pmt_t& packet, const packet_timing& timing);
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_PMT_H */
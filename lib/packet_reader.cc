@@ -0,0 +1,1052 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "coroutine.h"
+#include "debug.h"
+#include "packet_reader.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+bool within_range(double act, double exp, double tolerance)
+{
+    double max = exp * (1.0f + tolerance);
+    double min = exp * (1.0f - tolerance);
+
+    return (act > min) && (act < max);
+}
+
+struct timeout_error : public std::runtime_error {
+    timeout_error() :
+        std::runtime_error("timeout reading data")
+    { }
+};
+
+struct too_many_bits_error : public std::runtime_error {
+    too_many_bits_error() :
+        std::runtime_error("exceeded max allowed data bits")
+    { }
+};
+
+struct bad_transition_error : public std::runtime_error {
+    bad_transition_error() :
+        std::runtime_error("signal did not transition when expected")
+    { }
+};
+
+struct bad_midamble_error : public std::runtime_error {
+    bad_midamble_error() :
+        std::runtime_error("bad midamble")
+    { }
+};
+
+struct end_of_input : public std::runtime_error {
+    end_of_input() :
+        std::runtime_error("input ended during an attempt")
+    { }
+};
+}
+
+struct packet_reader::worker : public util::coroutine {
+    worker(double tolerance_) : tolerance(tolerance_)
+    {
+    }
+
+    static constexpr bool high = true;
+    static constexpr bool low = false;
+
+    double tolerance;
+    bool need_reset = false;
+
+    const run_t* data = nullptr;
+    const run_t* endptr = nullptr;
+
+    /*
+     * With fractional durations, as from an interpolating slicer, pulses
+     * are measured from edge to edge and the bit timing keeps its
+     * fractions. Otherwise run durations are whole samples, the first
+     * sample at each new level is consumed by the transition (see
+     * count_until) and the timing is rounded down to whole samples.
+     */
+    bool fractional = false;
+
+    /* The part of a pulse that its count leaves out. */
+    double edge_sample() const
+    {
+        return fractional ? 0 : 1;
+    }
+
+    /* The run under the cursor and how many of its samples are left. */
+    bool level = low;
+    double remaining = 0;
+    /* Total duration of all runs taken so far. */
+    double pulled = 0;
+    /* Where the real input ends while finish() plays out the silence. */
+    double input_end = std::numeric_limits<double>::infinity();
+    /* Set by finish() to unwind an attempt that is still waiting. */
+    bool abandon = false;
+
+    /*
+     * Lookback window for the sync search. While a sync train and
+     * preamble are being checked, every run taken is kept in 'history',
+     * starting with the high pulse the attempt began on. If the attempt
+     * fails, each later high pulse is another candidate alignment, so
+     * the runs after the first pulse are queued in 'replay' and read
+     * again before any new input. A candidate is only dropped once the
+     * checks have ruled it out. Attempts that outgrow the window are
+     * not replayed.
+     */
+    static constexpr size_t max_lookback = 1024;
+    bool recording = false;
+    double history_start = 0;
+    std::vector<run_t> history;
+    std::deque<run_t> replay;
+
+    int sync_count = 0;
+    uint64_t start_sample = 0;
+    std::vector<bool> packet_data;
+    std::vector<bool> packet_check;
+
+    std::deque<packet> packet_queue;
+
+    /*
+     * Failed attempts, if requested. Only attempts whose sync train was
+     * detected count, so noise does not flood the queue; it is also
+     * bounded in case nobody drains it.
+     */
+    bool report_failures = false;
+    bool synced = false;
+    std::deque<failure> failure_queue;
+    static constexpr size_t max_failures = 64;
+
+    /*
+     * Physical plausibility limits, converted to samples. A sync pulse
+     * narrower than min_width or wider than max_width, or a sync train
+     * shorter than min_sync_count pulses, is rejected. Zero disables a
+     * limit; without a sample rate only min_sync_count applies.
+     */
+    double sample_rate = 0;
+    int min_width = 0;
+    int max_width = 0;
+    int min_sync_count = 0;
+
+    /*
+     * Degraded mode, for when the host cannot keep up: packets get no
+     * pretty strings and the limits are raised to at least these
+     * floors, so noise is rejected before an attempt starts.
+     */
+    bool degraded = false;
+    static constexpr int degraded_min_width = 3;
+    static constexpr int degraded_min_sync_count = 4;
+
+    /* Set while waiting for the first pulse of a sync train. */
+    bool waiting = false;
+
+    /* Deferred by between_packets until the next attempt. */
+    std::function<void()> between;
+
+    /*
+     * Sync hints, when an external detector decides where sync trains
+     * start. A hinted train is followed for at most max_hinted_pulses.
+     */
+    struct sync_hint {
+        uint64_t sample;
+        double width;
+    };
+    bool hinted = false;
+    std::deque<sync_hint> hints;
+    static constexpr int max_hinted_pulses = 256;
+
+    /*
+     * Data lengths, in bits, that end a check copy as soon as its last
+     * bit arrives instead of after the trailing timeout. They are
+     * configured per deployment, learned from recent valid packets, or
+     * both.
+     */
+    std::vector<size_t> expected_bits;
+    bool learn_lengths = false;
+    std::deque<size_t> learned_bits;
+    static constexpr size_t max_learned = 8;
+
+    struct timing_params {
+        timing_params() :
+            one(0),
+            zero(0),
+            preamble(0),
+            end(0),
+            timeout(-1)
+        { }
+
+        timing_params(double width, bool fractional) :
+            one(width),
+            zero(fractional ? width / 2 : std::floor(width / 2)),
+            preamble(width * 2),
+            end(width * 4),
+            timeout(width * 8)
+        { }
+
+        double one, zero, preamble, end, timeout;
+    } timing;
+
+    virtual void on_reset() override
+    {
+        need_reset = false;
+        recording = false;
+        history.clear();
+        synced = false;
+        sync_count = 0;
+        packet_data.clear();
+        packet_check.clear();
+        timing = { };
+    }
+
+    bool has_next() const
+    {
+        return data != endptr;
+    }
+
+    void next_run()
+    {
+        run_t run;
+        if (!replay.empty()) {
+            run = replay.front();
+            replay.pop_front();
+        } else {
+            while (!has_next()) {
+                if (abandon) {
+                    throw end_of_input{};
+                }
+                yield();
+            }
+            run = *data++;
+        }
+
+        level = run_level(run);
+        remaining = fractional ? run_duration(run)
+                               : std::trunc(run_duration(run));
+        pulled += remaining;
+
+        if (recording) {
+            if (history.size() < max_lookback) {
+                history.push_back(run);
+            } else {
+                debug(debug_flags::decode, "sync attempt left lookback\n");
+                recording = false;
+                history.clear();
+            }
+        }
+    }
+
+    /* Start keeping runs, from the sample just consumed. */
+    void begin_lookback()
+    {
+        recording = true;
+        history_start = position() - edge_sample();
+        history.assign(1, make_run(level, remaining + edge_sample()));
+    }
+
+    /* The attempt matched; its runs will not be needed again. */
+    void end_lookback()
+    {
+        recording = false;
+        history.clear();
+    }
+
+    /* The attempt failed; queue the runs after its first pulse. */
+    void rewind_lookback()
+    {
+        if (!recording) {
+            return;
+        }
+
+        size_t skip = 0;
+        double pos = history_start;
+        while (skip < history.size() && run_level(history[skip]) == high) {
+            pos += run_duration(history[skip++]);
+        }
+
+        replay.insert(replay.begin(), history.begin() + skip, history.end());
+        pulled = pos;
+        remaining = 0;
+        end_lookback();
+    }
+
+    /* The absolute index of the next sample under the cursor. */
+    double position() const
+    {
+        return pulled - remaining;
+    }
+
+    /* The last sample of the attempt, never past the real input. */
+    uint64_t end_sample() const
+    {
+        return sample_index(std::min(position(), input_end) - edge_sample());
+    }
+
+    /* The sample at 'pos', which may be fractional. */
+    static uint64_t sample_index(double pos)
+    {
+        return pos > 0 ? (uint64_t)std::llround(pos) : 0;
+    }
+
+    /*
+     * Counts samples until the signal is at 'target', consuming the
+     * first sample at that level. Stops after 'max' samples (unless
+     * max is -1), consuming one more. This is the same accounting as
+     * stepping through the samples one at a time, so split runs and
+     * run boundaries never change the result. With fractional durations
+     * nothing is consumed and the count runs from edge to edge.
+     */
+    double count_until(bool target, double max)
+    {
+        double count = 0;
+        while (true) {
+            if (!remaining) {
+                next_run();
+            }
+
+            if (level == target) {
+                remaining = std::max(remaining - edge_sample(), 0.0);
+                return count;
+            }
+
+            if (max != -1 && remaining > max - count) {
+                remaining =
+                  std::max(remaining - (max - count + edge_sample()), 0.0);
+                return max;
+            }
+
+            count += remaining;
+            remaining = 0;
+        }
+    }
+    double count_until(bool target)
+    {
+        return count_until(target, timing.timeout);
+    }
+
+    void wait_until(bool target, double max)
+    {
+        (void)count_until(target, max);
+    }
+
+    void wait_until(bool target)
+    {
+        wait_until(target, timing.timeout);
+    }
+
+    std::string phy_pretty_packet()
+    {
+        std::ostringstream os;
+        os << std::setw(2) << sync_count << "SP ";
+        for (size_t idx = 0;
+             idx < std::max(packet_data.size(), packet_check.size());) {
+            if (idx >= packet_data.size()) {
+                os << "C";
+            } else if (idx >= packet_check.size()) {
+                os << "D";
+            } else if (packet_data[idx] != packet_check[idx]) {
+                os << "X";
+            } else {
+                os << (packet_data[idx] ? '1' : '0');
+            }
+
+            if (++idx % 4 == 0) {
+                os << " ";
+            }
+        }
+        return os.str();
+    }
+
+    std::string pretty_packet(const std::vector<uint8_t> data, bool check_valid)
+    {
+        std::ostringstream os;
+        os << std::setfill('0');
+        os << std::setw(2) << sync_count << "S ";
+        os << std::setw(3) << packet_data.size() << "B ";
+        os << (check_valid ? "\u2713" : "\u2717");
+        for (auto c : data) {
+            os << " " << std::hex << std::setw(2) << (int)c;
+        }
+        return os.str();
+    }
+
+    bool expected_length(size_t bits) const
+    {
+        return std::find(expected_bits.begin(), expected_bits.end(), bits) !=
+                 expected_bits.end() ||
+               std::find(learned_bits.begin(), learned_bits.end(), bits) !=
+                 learned_bits.end();
+    }
+
+    void learn_length(size_t bits)
+    {
+        if (!learn_lengths || expected_length(bits)) {
+            return;
+        }
+
+        learned_bits.push_back(bits);
+        if (learned_bits.size() > max_learned) {
+            learned_bits.pop_front();
+        }
+    }
+
+    void push_bit(bool bit, uint8_t& c, size_t idx, std::vector<uint8_t>& out)
+    {
+        c <<= 1;
+        c |= bit;
+        if (((idx + 1) % 8) == 0) {
+            out.push_back(c);
+            c = 0;
+        }
+    }
+
+    void produce_packet()
+    {
+        bool check_valid = true;
+
+        const size_t num_bytes =
+          (packet_data.size() / 8) + ((packet_data.size() % 8) != 0);
+        uint8_t byte = 0;
+        size_t idx = 0;
+        std::vector<uint8_t> data;
+        data.reserve(num_bytes);
+        for (; idx < packet_data.size(); idx++) {
+            if (idx >= packet_data.size()) {
+                check_valid = false;
+                break;
+            }
+
+            if (
+              idx >= packet_check.size() ||
+              packet_data[idx] != packet_check[idx]) {
+                check_valid = false;
+            }
+
+            push_bit(packet_data[idx], byte, idx, data);
+        }
+
+        while (data.size() < num_bytes) {
+            push_bit(0, byte, idx++, data);
+        }
+
+        packet result;
+        if (!degraded) {
+            auto phy_packet = phy_pretty_packet();
+            debug(debug_flags::decode, "phy: %s\n", phy_packet.c_str());
+
+            result.pretty = pretty_packet(data, check_valid);
+            result.phy_pretty = phy_packet;
+        }
+        result.data = std::move(data);
+        result.bit_count = packet_data.size();
+        result.sync_count = sync_count;
+        const double width = timing.one + edge_sample();
+        result.sync_width = (int)std::lround(width);
+        if (sample_rate > 0) {
+            result.sync_width_us = width * 1e6 / sample_rate;
+        }
+        result.valid_check = check_valid;
+        if (check_valid) {
+            learn_length(result.bit_count);
+        }
+        result.start_sample = start_sample;
+        result.end_sample = end_sample();
+        if (!check_valid) {
+            fail("check_mismatch");
+        }
+
+        packet_queue.push_back(std::move(result));
+    }
+
+    void fail(const char* reason)
+    {
+        if (!report_failures || !synced) {
+            return;
+        }
+
+        failure_queue.push_back(
+          { start_sample, end_sample(), reason });
+        if (failure_queue.size() > max_failures) {
+            failure_queue.pop_front();
+        }
+    }
+
+    virtual void run() override
+    {
+        try {
+            read_packet();
+        } catch (const timeout_error& err) {
+        } catch (const bad_midamble_error& err) {
+            fail("bad_midamble");
+        } catch (const too_many_bits_error& err) {
+            fail("too_many_bits");
+        } catch (const end_of_input& err) {
+        } catch (const std::exception& ex) {
+            debug(debug_flags::decode, "unhandled exception: %s\n", ex.what());
+        }
+    }
+
+    virtual void on_exit() override
+    {
+        need_reset = true;
+    }
+
+    /*
+     * Whole-sample pulse counts leave out the sample that starts the
+     * pulse, which is consumed by the transition, so a pulse is one
+     * sample wider.
+     */
+    bool plausible_width(double count) const
+    {
+        const double width = count + edge_sample();
+        return width >= effective_min_width() &&
+               (!max_width || width <= max_width);
+    }
+
+    int effective_min_width() const
+    {
+        return degraded ? std::max(min_width, degraded_min_width) : min_width;
+    }
+
+    int effective_min_sync_count() const
+    {
+        return degraded ? std::max(min_sync_count, degraded_min_sync_count)
+                        : min_sync_count;
+    }
+
+    /*
+     * Waits for a high pulse that could start a sync train and returns
+     * its width. Pulses outside the width limits are skipped here,
+     * without starting an attempt, since they cannot hide a candidate.
+     */
+    double wait_for_sync_pulse()
+    {
+        while (true) {
+            waiting = true;
+            wait_until(high);
+            waiting = false;
+            start_sample = sample_index(position() - edge_sample());
+            begin_lookback();
+
+            double width = count_until(low, max_width ? max_width : -1);
+            if (plausible_width(width)) {
+                return width;
+            }
+
+            if (level == high) {
+                wait_until(low, -1);
+            }
+        }
+    }
+
+    /*
+     * Skips input up to half a pulse ahead of the next hint that has not
+     * been passed yet, and returns that hint.
+     */
+    sync_hint wait_for_hint()
+    {
+        waiting = true;
+        while (true) {
+            while (!hints.empty() && position() > hints.front().sample) {
+                hints.pop_front();
+            }
+
+            if (!hints.empty()) {
+                const auto hint = hints.front();
+                const double target =
+                  hint.sample - std::floor(hint.width / 2);
+                if (position() >= target) {
+                    hints.pop_front();
+                    waiting = false;
+                    return hint;
+                }
+                if (remaining > target - position()) {
+                    remaining -= target - position();
+                    continue;
+                }
+            }
+
+            remaining = 0;
+            next_run();
+        }
+    }
+
+    /*
+     * Follows a hinted sync train up to its preamble. Unlike
+     * detect_sync_width, a pulse or gap that is out of range does not
+     * end the attempt, so the train survives the odd noise spike or
+     * dropout; only a gap longer than the preamble or a train that
+     * never ends does.
+     */
+    bool follow_sync_hint(const sync_hint& hint)
+    {
+        const double pulse = hint.width - edge_sample();
+        timing = timing_params { fractional ? pulse : std::floor(pulse),
+                                 fractional };
+
+        wait_until(high);
+        if (level != high) {
+            return false;
+        }
+        start_sample = sample_index(position() - edge_sample());
+
+        const double max_gap = timing.preamble * (1 + tolerance);
+        double total = 0;
+        int counted = 0;
+        for (int pulses = 0; pulses < max_hinted_pulses; ++pulses) {
+            const double hi_count = count_until(low, max_gap);
+            if (level != low) {
+                return false;
+            }
+            const bool in_range = within_range(hi_count, timing.one, tolerance);
+            if (in_range) {
+                total += hi_count;
+                counted++;
+            }
+
+            const double lo_count = count_until(high, max_gap);
+            if (within_range(lo_count, timing.preamble, tolerance)) {
+                if (counted) {
+                    const double width = total / counted;
+                    timing = timing_params {
+                        fractional ? width : std::floor(width), fractional
+                    };
+                }
+                debug(
+                  debug_flags::decode,
+                  "followed sync %g: %d pulses\n",
+                  timing.one,
+                  sync_count);
+                return true;
+            }
+            if (level != high) {
+                return false;
+            }
+            if (in_range) {
+                sync_count += 1;
+            }
+        }
+
+        debug(debug_flags::decode, "hinted sync train never ended\n");
+        return false;
+    }
+
+    bool detect_sync_width(double hi_count)
+    {
+        double detected_width = 0;
+        /* Until a width is detected, no sync gap exceeds 4x the max. */
+        double wait_time = max_width ? max_width * 4 : -1;
+        while (true) {
+            double lo_count = count_until(high, wait_time);
+
+            if (detected_width > 1 && lo_count > (1.7 * detected_width)) {
+                if (sync_count < effective_min_sync_count()) {
+                    debug(
+                      debug_flags::decode,
+                      "short sync train: %d < %d\n",
+                      sync_count,
+                      effective_min_sync_count());
+                    return false;
+                }
+
+                debug(
+                  debug_flags::decode, "detected sync %g\n:", detected_width);
+                timing = timing_params { detected_width, fractional };
+                return true;
+            }
+
+            double total = hi_count + lo_count;
+            if (
+              !within_range(hi_count, total / 2.0, tolerance) ||
+              !within_range(lo_count, total / 2.0, tolerance)) {
+                debug(
+                  debug_flags::decode,
+                  "bad sync: hi(%g) lo(%g) avg(%g)\n",
+                  hi_count,
+                  lo_count,
+                  detected_width);
+                return false;
+            }
+
+            detected_width =
+              (detected_width * sync_count + hi_count) / (sync_count + 1);
+            if (!fractional) {
+                detected_width = std::floor(detected_width);
+            }
+            sync_count += 1;
+            wait_time = detected_width * 4;
+
+            hi_count = count_until(low, wait_time);
+            if (!plausible_width(hi_count)) {
+                debug(
+                  debug_flags::decode,
+                  "implausible sync pulse: hi(%g) min(%d) max(%d)\n",
+                  hi_count,
+                  effective_min_width(),
+                  max_width);
+                return false;
+            }
+        }
+    }
+
+    double receive_bit(bool target, std::vector<bool>& out)
+    {
+        if (out.size() > 1024) {
+            debug(debug_flags::decode, "Exceeded packet bit limit");
+            throw too_many_bits_error{};
+        }
+
+        double count = count_until(target);
+        if (within_range(count, timing.one, tolerance)) {
+            out.push_back(true);
+            return 0;
+        } else if (within_range(count, timing.zero, tolerance)) {
+            out.push_back(false);
+            return 0;
+        }
+
+        return count;
+    }
+
+    /*
+     * Receives bits into 'out' until the signal stops following the bit
+     * timing or, if 'length' is non-zero, as soon as 'length' bits have
+     * been received.
+     */
+    void receive_data(std::vector<bool>& out, size_t length = 0)
+    {
+        while (true) {
+            double lo = receive_bit(high, out);
+            if (lo == 0 && out.size() == length) {
+                return;
+            }
+
+            if (within_range(lo, timing.preamble, tolerance)) {
+                /* start of a mid-amble */
+                if (!within_range(count_until(low), timing.preamble, tolerance)) {
+                    throw bad_midamble_error { };
+                }
+            } else if (lo > timing.end) {
+                return;
+            } else if (lo != 0) {
+                debug(
+                  debug_flags::decode,
+                  "Signal did not go high when expected.\n");
+                debug(
+                  debug_flags::decode,
+                  "lo(%g) one(%g) zero(%g) bit(%d)\n",
+                  lo,
+                  timing.one,
+                  timing.zero,
+                  out.size());
+                return;
+            }
+
+            double hi = receive_bit(low, out);
+            if (hi == 0 && out.size() == length) {
+                return;
+            }
+            if (hi != 0) {
+                debug(
+                  debug_flags::decode,
+                  "Signal did not go low when expected.\n");
+                debug(
+                  debug_flags::decode,
+                  "hi(%g) lo(%g) one(%g) zero(%g) preamb(%g) bit(%d)\n",
+                  hi,
+                  lo,
+                  timing.one,
+                  timing.zero,
+                  timing.preamble,
+                  out.size());
+            }
+
+            if (lo != 0) {
+                return;
+            }
+        }
+    }
+
+    void read_packet()
+    {
+        if (between) {
+            auto action = std::move(between);
+            between = nullptr;
+            action();
+        }
+
+        if (hinted) {
+            if (!follow_sync_hint(wait_for_hint())) {
+                return;
+            }
+        } else {
+            double first_pulse = wait_for_sync_pulse();
+
+            if (!detect_sync_width(first_pulse)) {
+                rewind_lookback();
+                return;
+            }
+        }
+        synced = true;
+
+        double preamble_size = count_until(low);
+        if (!within_range(preamble_size, timing.preamble, tolerance)) {
+            debug(
+              debug_flags::decode,
+              "Bad preamble: %g != %g\n",
+              preamble_size,
+              timing.preamble);
+            fail("bad_preamble");
+            rewind_lookback();
+            return;
+        } else {
+            debug(
+              debug_flags::decode,
+              "preamble: actual(%g) expected(%g)\n",
+              preamble_size,
+              timing.preamble);
+        }
+
+        end_lookback();
+
+        debug(debug_flags::decode, "begin receive data\n");
+        receive_data(packet_data);
+        debug(debug_flags::decode, "begin receive check\n");
+        receive_data(
+          packet_check,
+          expected_length(packet_data.size()) ? packet_data.size() : 0);
+
+        if (packet_data.size() > 0 && packet_check.size() > 0) {
+            produce_packet();
+        } else {
+            fail("timeout");
+        }
+    }
+
+    void resume(const run_t* new_data, int size)
+    {
+        assert(!has_next());
+
+        data = new_data;
+        endptr = data + size;
+
+        while (has_next() || remaining || !replay.empty()) {
+            coroutine::resume();
+            if (need_reset) {
+                reset();
+            }
+        }
+    }
+
+    /*
+     * Play out a low run longer than any timeout, so the attempt in
+     * progress completes or fails, then start over at the end of the
+     * real input. The silence is never kept for replay, and an attempt
+     * that outlasts it, such as a sync train still in its first gap, is
+     * abandoned. Hints past the end are kept for the input that may
+     * follow.
+     */
+    void finish()
+    {
+        const double end = position();
+        std::deque<sync_hint> later;
+        while (!hints.empty() && hints.back().sample >= end) {
+            later.push_front(hints.back());
+            hints.pop_back();
+        }
+
+        end_lookback();
+        input_end = end;
+        const run_t silence = make_run(low, (float)(1 << 24));
+        resume(&silence, 1);
+        input_end = std::numeric_limits<double>::infinity();
+
+        abandon = true;
+        coroutine::resume();
+        abandon = false;
+        reset();
+        replay.clear();
+        waiting = true;
+
+        level = low;
+        pulled = end;
+        remaining = 0;
+        hints = std::move(later);
+    }
+
+    bool has_packet() const
+    {
+        return packet_queue.size();
+    }
+
+    packet next_packet()
+    {
+        auto result = packet_queue.front();
+        packet_queue.pop_front();
+        return result;
+    }
+};
+
+constexpr int packet_reader::worker::degraded_min_width;
+constexpr int packet_reader::worker::degraded_min_sync_count;
+constexpr size_t packet_reader::worker::max_failures;
+constexpr int packet_reader::worker::max_hinted_pulses;
+
+packet_reader::packet_reader(double tolerance) : worker_(new worker{tolerance})
+{
+}
+
+packet_reader::~packet_reader()
+{
+}
+
+void packet_reader::set_tolerance(double tolerance)
+{
+    worker_->tolerance = tolerance;
+}
+
+void packet_reader::set_limits(
+  double sample_rate,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count)
+{
+    auto samples = [sample_rate](double us) {
+        return sample_rate > 0 ? (int)std::lround(us * sample_rate / 1e6) : 0;
+    };
+
+    worker_->sample_rate = sample_rate;
+    worker_->min_width = samples(min_width_us);
+    worker_->max_width = samples(max_width_us);
+    worker_->min_sync_count = min_sync_count;
+}
+
+void packet_reader::expect_lengths(const std::vector<int>& bits, bool learn)
+{
+    worker_->expected_bits.assign(bits.begin(), bits.end());
+    worker_->learn_lengths = learn;
+    if (!learn) {
+        worker_->learned_bits.clear();
+    }
+}
+
+void packet_reader::set_fractional(bool fractional)
+{
+    worker_->fractional = fractional;
+}
+
+void packet_reader::set_degraded(bool degraded)
+{
+    worker_->degraded = degraded;
+}
+
+bool packet_reader::idle() const
+{
+    return worker_->waiting && worker_->replay.empty();
+}
+
+void packet_reader::between_packets(std::function<void()> action)
+{
+    if (idle()) {
+        worker_->between = nullptr;
+        action();
+    } else {
+        worker_->between = std::move(action);
+    }
+}
+
+int packet_reader::min_pulse_width() const
+{
+    return std::max(worker_->effective_min_width(), 1);
+}
+
+void packet_reader::set_sync_hints(bool hints)
+{
+    worker_->hinted = hints;
+    if (!hints) {
+        worker_->hints.clear();
+    }
+}
+
+void packet_reader::add_sync_hint(std::uint64_t sample, double width)
+{
+    worker_->hints.push_back({ sample, width });
+}
+
+void packet_reader::resume(const run_t* runs, int count)
+{
+    worker_->resume(runs, count);
+}
+
+void packet_reader::finish()
+{
+    worker_->finish();
+}
+
+bool packet_reader::has_packet() const
+{
+    return worker_->has_packet();
+}
+
+packet packet_reader::next_packet()
+{
+    return worker_->next_packet();
+}
+
+void packet_reader::set_report_failures(bool report)
+{
+    worker_->report_failures = report;
+    if (!report) {
+        worker_->failure_queue.clear();
+    }
+}
+
+bool packet_reader::has_failure() const
+{
+    return !worker_->failure_queue.empty();
+}
+
+packet_reader::failure packet_reader::next_failure()
+{
+    auto result = worker_->failure_queue.front();
+    worker_->failure_queue.pop_front();
+    return result;
+}
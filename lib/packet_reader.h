@@ -0,0 +1,158 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_READER_H
+#define INCLUDED_OOK_PACKET_READER_H
+
+#include <ook/packet.h>
+#include <ook/run.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Runs the OOK packet protocol (sync train, preamble, data, midamble,
+ * check copy) over a stream of runs and queues every packet it
+ * decodes. Runs may be split at arbitrary points; only
+ * the sequence of levels matters.
+ */
+class packet_reader
+{
+  public:
+    /*
+     * An attempt that got as far as a detected sync train but produced
+     * no valid packet. 'reason' is one of "bad_preamble", "bad_midamble",
+     * "too_many_bits", "timeout" (the data or check copy never started)
+     * or "check_mismatch" (the packet is still published). The samples
+     * run from the start of the sync train to where the attempt ended.
+     */
+    struct failure {
+        std::uint64_t start_sample;
+        std::uint64_t end_sample;
+        const char* reason;
+    };
+
+  private:
+    struct worker;
+    std::unique_ptr<worker> worker_;
+
+  public:
+    explicit packet_reader(double tolerance);
+    ~packet_reader();
+
+    void set_tolerance(double tolerance);
+
+    /*
+     * Reject sync trains whose pulses are narrower than 'min_width_us'
+     * or wider than 'max_width_us', or that have fewer than
+     * 'min_sync_count' pulses. The widths need the sample rate; zero
+     * disables a limit. With a sample rate, packets also report their
+     * sync width in microseconds.
+     */
+    void set_limits(
+      double sample_rate,
+      double min_width_us,
+      double max_width_us,
+      int min_sync_count);
+
+    /*
+     * Finish a packet as soon as its check copy reaches the length of
+     * its data copy, if that length is one of 'bits' or, when 'learn'
+     * is set, the length of a recent valid packet. Otherwise the check
+     * copy only ends after the signal has stayed low for the timeout.
+     */
+    void expect_lengths(const std::vector<int>& bits, bool learn);
+
+    /*
+     * Keep the fractions of run durations, as produced by an
+     * interpolating slicer, when measuring pulses and classifying bits.
+     */
+    void set_fractional(bool fractional);
+
+    /*
+     * Trade decoding quality for speed: packets get no pretty strings,
+     * and sync trains must have wider pulses and more of them (see
+     * packet_reader.cc for the floors).
+     */
+    void set_degraded(bool degraded);
+
+    /*
+     * True if the reader is waiting for a new sync train and has no old
+     * input to look at again, so a low span could be skipped unread.
+     */
+    bool idle() const;
+
+    /*
+     * Run 'action' once the reader is between packets: now if it is
+     * waiting for a sync train, otherwise before its next attempt
+     * starts. A later action replaces one that is still waiting.
+     */
+    void between_packets(std::function<void()> action);
+
+    /* The narrowest sync pulse currently accepted, in samples. */
+    int min_pulse_width() const;
+
+    /*
+     * Only look for sync trains where a hint says one starts, instead of
+     * at every pulse. Hints must be added before the runs they point
+     * into are fed; see add_sync_hint.
+     */
+    void set_sync_hints(bool hints);
+
+    /*
+     * A sync train likely starts with a pulse at 'sample', 'width'
+     * samples wide. From there the train only has to keep roughly to the
+     * width until its preamble: pulses broken up by noise are tolerated,
+     * and the timing is taken from the pulses that are in range.
+     */
+    void add_sync_hint(std::uint64_t sample, double width);
+
+    /* Feed 'count' runs to the protocol state machine. */
+    void resume(const run_t* runs, int count);
+
+    /*
+     * The input has ended, for now: complete or fail the packet in
+     * progress as a long silence would, without counting the silence
+     * as samples. Input fed afterwards continues at the same position.
+     */
+    void finish();
+
+    bool has_packet() const;
+    packet next_packet();
+
+    /* Queue a failure record for each failed attempt; off by default. */
+    void set_report_failures(bool report);
+
+    bool has_failure() const;
+    failure next_failure();
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_READER_H */
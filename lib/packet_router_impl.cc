@@ -0,0 +1,179 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <stdexcept>
+
+#include "packet_router_impl.h"
+
+namespace
+{
+const pmt::pmt_t packet_sym = pmt::mp("packet");
+const pmt::pmt_t unmatched_sym = pmt::mp("unmatched");
+const pmt::pmt_t data_sym = pmt::mp("data");
+const pmt::pmt_t bit_count_sym = pmt::mp("bit_count");
+const pmt::pmt_t valid_check_sym = pmt::mp("valid_check");
+
+const int unmatched_port = 0;
+}
+
+namespace gr
+{
+namespace ook
+{
+packet_router::sptr packet_router::make(
+  const std::vector<std::string>& rules,
+  bool require_valid,
+  int min_bits,
+  int max_bits)
+{
+    return gnuradio::get_initial_sptr(
+      new packet_router_impl(rules, require_valid, min_bits, max_bits));
+}
+
+/*
+ * The private constructor
+ */
+packet_router_impl::packet_router_impl(
+  const std::vector<std::string>& rules,
+  bool require_valid,
+  int min_bits,
+  int max_bits)
+    : gr::block(
+        "packet_router",
+        gr::io_signature::make(0, 0, 0),
+        gr::io_signature::make(0, 0, 0)),
+      ports_{ unmatched_sym },
+      require_valid_(require_valid),
+      min_bits_(min_bits),
+      max_bits_(max_bits)
+{
+    for (const auto& rule : rules) {
+        auto equals = rule.find('=');
+        if (equals == std::string::npos || equals == 0) {
+            throw std::invalid_argument("bad routing rule: " + rule);
+        }
+
+        auto port = pmt::mp(rule.substr(0, equals));
+        if (pmt::eqv(port, packet_sym)) {
+            throw std::invalid_argument("reserved port name: " + rule);
+        }
+
+        std::vector<uint8_t> value, mask;
+        util::packet_trie::parse_pattern(rule.substr(equals + 1), value, mask);
+        trie_.add(value, mask);
+
+        size_t index = 0;
+        while (index < ports_.size() && !pmt::eqv(ports_[index], port)) {
+            index++;
+        }
+        if (index == ports_.size()) {
+            ports_.push_back(port);
+        }
+        rule_ports_.push_back((int)index);
+    }
+
+    message_port_register_in(packet_sym);
+    set_msg_handler(
+      packet_sym, [this](pmt::pmt_t p) { handle_packet(p); });
+    for (const auto& port : ports_) {
+        message_port_register_out(port);
+    }
+}
+
+/*
+ * Our virtual destructor.
+ */
+packet_router_impl::~packet_router_impl()
+{
+}
+
+int packet_router_impl::route(const pmt::pmt_t& packet) const
+{
+    if (!pmt::is_dict(packet)) {
+        throw std::invalid_argument("packet_router expects packet dicts");
+    }
+
+    auto data = pmt::dict_ref(packet, data_sym, pmt::PMT_NIL);
+    size_t size = 0;
+    const uint8_t* payload = nullptr;
+    if (pmt::is_u8vector(data)) {
+        payload = pmt::u8vector_elements(data, size);
+    }
+
+    if (require_valid_) {
+        auto valid = pmt::dict_ref(packet, valid_check_sym, pmt::PMT_F);
+        if (!pmt::is_bool(valid) || !pmt::to_bool(valid)) {
+            return -1;
+        }
+    }
+
+    if (min_bits_ > 0 || max_bits_ > 0) {
+        auto field = pmt::dict_ref(packet, bit_count_sym, pmt::PMT_NIL);
+        uint64_t bits = pmt::is_null(field) ? size * 8 : pmt::to_uint64(field);
+        if (bits < (uint64_t)min_bits_ ||
+            (max_bits_ > 0 && bits > (uint64_t)max_bits_)) {
+            return -1;
+        }
+    }
+
+    int rule = trie_.match(payload, size);
+    return rule < 0 ? unmatched_port : rule_ports_[rule];
+}
+
+void packet_router_impl::handle_packet(pmt::pmt_t packet)
+{
+    if (!pmt::is_vector(packet)) {
+        int port = route(packet);
+        if (port >= 0) {
+            message_port_pub(ports_[port], packet);
+        }
+        return;
+    }
+
+    std::vector<std::vector<pmt::pmt_t>> batches(ports_.size());
+    for (size_t i = 0; i < pmt::length(packet); ++i) {
+        auto item = pmt::vector_ref(packet, i);
+        int port = route(item);
+        if (port >= 0) {
+            batches[port].push_back(item);
+        }
+    }
+
+    for (size_t port = 0; port < ports_.size(); ++port) {
+        const auto& batch = batches[port];
+        if (batch.empty()) {
+            continue;
+        }
+
+        auto result = pmt::make_vector(batch.size(), pmt::PMT_NIL);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            pmt::vector_set(result, i, batch[i]);
+        }
+        message_port_pub(ports_[port], result);
+    }
+}
+
+} /* namespace ook */
+} /* namespace gr */
@@ -0,0 +1,58 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_ROUTER_IMPL_H
+#define INCLUDED_OOK_PACKET_ROUTER_IMPL_H
+
+#include <ook/packet_router.h>
+
+#include "packet_trie.h"
+
+namespace gr
+{
+namespace ook
+{
+class packet_router_impl : public packet_router
+{
+  private:
+    util::packet_trie trie_;
+    std::vector<int> rule_ports_;
+    std::vector<pmt::pmt_t> ports_;
+    bool require_valid_;
+    int min_bits_;
+    int max_bits_;
+
+    /* Index into ports_ for a packet, or -1 to drop it. */
+    int route(const pmt::pmt_t& packet) const;
+    void handle_packet(pmt::pmt_t packet);
+
+  public:
+    packet_router_impl(
+      const std::vector<std::string>& rules,
+      bool require_valid,
+      int min_bits,
+      int max_bits);
+    ~packet_router_impl();
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_ROUTER_IMPL_H */
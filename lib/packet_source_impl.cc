@@ -23,193 +23,57 @@
 #endif
 
 #include <gnuradio/io_signature.h>
+#include <stdexcept>
 #include <vector>
 #include "packet_source_impl.h"
 
-#include "coroutine.h"
-
 namespace {
 const pmt::pmt_t packet_sym = pmt::mp("packets");
+const pmt::pmt_t packet_start_sym = pmt::mp("packet_start");
+const pmt::pmt_t packet_end_sym = pmt::mp("packet_end");
+const pmt::pmt_t seq_sym = pmt::mp("seq");
+const pmt::pmt_t data_sym = pmt::mp("data");
+
+/* Output item sizes, in the order of packet_source_impl::output_format. */
+const char* const format_names[] = { "float", "complex", "sc16", "sc8" };
+const int format_sizes[] = { sizeof(float),
+                             sizeof(gr_complex),
+                             2 * sizeof(int16_t),
+                             2 * sizeof(int8_t) };
+
+int format_index(const std::string& format)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (format == format_names[i]) {
+            return i;
+        }
+    }
+    throw std::invalid_argument("packet_source: unknown format " + format);
+}
 }
 
 namespace gr
 {
 namespace ook
 {
-struct packet_source_impl::worker : public util::coroutine {
-    int stop_after;
-    int ms_between_xmit;
-    const int ms;
-
-    float* out;
-    float* endptr;
-
-    std::deque<std::vector<int>> packet_queue;
-
-    worker(
-        std::vector<int> init_data,
-        int stop_after,
-        int ms_between_xmit,
-        int sample_rate) :
-        stop_after(stop_after),
-        ms_between_xmit(ms_between_xmit),
-        ms(sample_rate / 1000),
-        out(nullptr),
-        endptr(nullptr)
-    {
-        if (!init_data.empty()) {
-            packet_queue.push_back(init_data);
-        }
-    }
-
-    void produce(float value)
-    {
-        while (out == endptr) {
-            yield();
-        }
-
-        *out = value;
-        out++;
-    }
-
-    void produce_many(int n, float value)
-    {
-        for (int i = 0; i < n; ++i) {
-            produce(value);
-        }
-    }
-
-    void pulse(int hi, int lo)
-    {
-        produce_many(hi, 1.0f);
-        produce_many(lo, 0.0f);
-    }
-
-    void pulse(int w)
-    {
-        pulse(w, w);
-    }
-
-    void blank(int time = 10)
-    {
-        produce_many(time * ms, 0.0f);
-    }
-
-    void sync()
-    {
-        for (int i = 0; i < 40; ++i) {
-            pulse(1.0f * ms);
-        }
-        produce_many(1.0 * ms, 1.0f);
-    }
-
-    void preamble()
-    {
-        produce_many(2 * ms, 0.0f);
-        produce_many(2 * ms, 1.0f);
-    }
-
-    void midamble()
-    {
-        preamble();
-    }
-
-    void postamble()
-    {
-    }
-
-    static float value(int idx)
-    {
-        return (idx & 1) ? 1.0f : 0.0f;
-    }
-
-    void zero(int idx)
-    {
-        produce_many(ms / 2, value(idx));
-    }
-
-    void one(int idx)
-    {
-        produce_many(1 * ms, value(idx));
-    }
-
-    void bit(bool v, int idx)
-    {
-        if (v)
-            one(idx);
-        else
-            zero(idx);
-    }
-
-    void data(int c)
-    {
-        for (int i = 0; i < 8; ++i) {
-            bit((c >> (7 - i)) & 1, i);
-        }
-    }
-
-    void data(const std::vector<int>& packet)
-    {
-        for (int c : packet) {
-            data(c);
-        }
-    }
-
-    void enqueue(pmt::pmt_t packet)
-    {
-        packet_queue.push_back(s32vector_elements(packet));
-    }
-
-    void send_packet(const std::vector<int>& packet)
-    {
-        blank();
-        sync();
-        preamble();
-        data(packet);
-        midamble();
-        data(packet);
-        postamble();
-        blank(ms_between_xmit);
-        stop_after = std::max(-1, stop_after - 1);
-    }
-
-    void run()
-    {
-        while (stop_after) {
-            while (packet_queue.empty()) {
-                blank();
-            }
-            send_packet(packet_queue.front());
-            packet_queue.pop_front();
-        }
-    }
-
-    int resume(float* data, int size)
-    {
-        if (stop_after == 0) {
-            return 0;
-        }
-
-        out = data;
-        endptr = data + size;
-        coroutine::resume();
-
-        return (int)(out - data);
-    }
-};
-
 packet_source::sptr packet_source::make(
-  const std::vector<int>& data,
+  const std::vector<uint8_t>& data,
   int stop_after,
   int ms_between_xmit,
-  int sample_rate)
+  int sample_rate,
+  const std::string& format,
+  double if_offset_hz,
+  double amplitude)
 {
     return gnuradio::get_initial_sptr(
       new packet_source_impl {
         data,
         stop_after,
         ms_between_xmit,
-        sample_rate
+        sample_rate,
+        format,
+        if_offset_hz,
+        amplitude
       }
     );
 }
@@ -218,26 +82,33 @@ packet_source::sptr packet_source::make(
  * The private constructor
  */
 packet_source_impl::packet_source_impl(
-  const std::vector<int>& data,
+  const std::vector<uint8_t>& data,
   int stop_after,
   int ms_between_xmit,
-  int sample_rate) :
+  int sample_rate,
+  const std::string& format,
+  double if_offset_hz,
+  double amplitude) :
     gr::sync_block(
         "packet_source",
         gr::io_signature::make(0, 0, 0),
-        gr::io_signature::make(1, 1, sizeof(float))
+        gr::io_signature::make(1, 1, format_sizes[format_index(format)])
     ),
-    worker_(
-        new worker {
-            data,
-            stop_after,
-            ms_between_xmit,
-            sample_rate
-        }
-    )
+    transmitter_(stop_after, ms_between_xmit, sample_rate),
+    format_((output_format)format_index(format)),
+    nco_(if_offset_hz, sample_rate, amplitude)
 {
+    if (format_ >= complex_int16 && (amplitude < 0 || amplitude > 1)) {
+        throw std::invalid_argument(
+          "packet_source: integer formats need an amplitude within [0, 1]");
+    }
+
+    if (!data.empty()) {
+        enqueue(pmt::init_u8vector(data.size(), data));
+    }
+
     message_port_register_in(packet_sym);
-    set_msg_handler(packet_sym, [this](pmt::pmt_t p) { worker_->enqueue(p); });
+    set_msg_handler(packet_sym, [this](pmt::pmt_t p) { enqueue(p); });
 }
 
 /*
@@ -247,13 +118,82 @@ packet_source_impl::~packet_source_impl()
 {
 }
 
+/*
+ * Accepts a u8vector, a PDU (metadata . u8vector) or, for backwards
+ * compatibility, an s32vector of byte values. u8vector payloads are
+ * queued as they are and read in place when transmitted.
+ */
+void packet_source_impl::enqueue(pmt::pmt_t msg)
+{
+    if (pmt::is_pair(msg)) {
+        msg = pmt::cdr(msg);
+    }
+
+    if (pmt::is_s32vector(msg)) {
+        auto values = pmt::s32vector_elements(msg);
+        std::vector<uint8_t> bytes(values.begin(), values.end());
+        msg = pmt::init_u8vector(bytes.size(), bytes);
+    }
+
+    if (!pmt::is_u8vector(msg)) {
+        throw std::invalid_argument(
+          "packet_source: expected a u8vector or PDU");
+    }
+
+    size_t size = 0;
+    const uint8_t* data = pmt::u8vector_elements(msg, size);
+    transmitter_.enqueue(data, size, std::make_shared<pmt::pmt_t>(msg));
+}
+
 int packet_source_impl::work(
   int noutput_items,
   gr_vector_const_void_star& input_items,
   gr_vector_void_star& output_items)
 {
-    int result =
-      worker_->resume(reinterpret_cast<float*>(output_items[0]), noutput_items);
+    const auto srcid = pmt::intern(alias());
+    const auto tag_boundary = [this, &srcid](const core::transmission& t) {
+        if (t.start) {
+            auto info = pmt::make_dict();
+            info = pmt::dict_add(info, seq_sym, pmt::from_uint64(t.seq));
+            info = pmt::dict_add(
+              info, data_sym, *static_cast<const pmt::pmt_t*>(t.context));
+            current_info_ = info;
+        }
+        add_item_tag(
+          0,
+          nitems_written(0) + t.offset,
+          t.start ? packet_start_sym : packet_end_sym,
+          current_info_,
+          srcid);
+    };
+
+    int result;
+    if (format_ == envelope) {
+        result = transmitter_.generate(
+          reinterpret_cast<float*>(output_items[0]),
+          noutput_items,
+          tag_boundary);
+    } else {
+        /* Key the carrier with the envelope, from a scratch buffer. */
+        envelope_.resize(noutput_items);
+        result = transmitter_.generate(
+          envelope_.data(), noutput_items, tag_boundary);
+        const float* keying = envelope_.data();
+        if (format_ == complex_float) {
+            nco_.mix(
+              keying, result, reinterpret_cast<gr_complex*>(output_items[0]));
+        } else if (format_ == complex_int16) {
+            nco_.mix(
+              keying,
+              result,
+              reinterpret_cast<std::complex<int16_t>*>(output_items[0]));
+        } else {
+            nco_.mix(
+              keying,
+              result,
+              reinterpret_cast<std::complex<int8_t>*>(output_items[0]));
+        }
+    }
 
     if (!result) return -1;
     return result;
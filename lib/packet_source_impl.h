@@ -21,8 +21,11 @@
 #ifndef INCLUDED_OOK_PACKET_SOURCE_IMPL_H
 #define INCLUDED_OOK_PACKET_SOURCE_IMPL_H
 
+#include <ook/core.h>
 #include <ook/packet_source.h>
-#include <memory>
+#include <vector>
+
+#include "nco.h"
 
 namespace gr
 {
@@ -31,15 +34,26 @@ namespace ook
 class packet_source_impl : public packet_source
 {
   private:
-    struct worker;
-    std::unique_ptr<worker> worker_;
+    core::transmitter transmitter_;
+    /* The tag value of the packet being sent. */
+    pmt::pmt_t current_info_;
+
+    enum output_format { envelope, complex_float, complex_int16, complex_int8 };
+    const output_format format_;
+    util::nco nco_;
+    std::vector<float> envelope_;
+
+    void enqueue(pmt::pmt_t msg);
 
   public:
     packet_source_impl(
-        const std::vector<int>& nibbles,
+        const std::vector<uint8_t>& data,
         int stop_after = 1,
         int ms_between_xmit = 10,
-        int sample_rate = 32000);
+        int sample_rate = 32000,
+        const std::string& format = "float",
+        double if_offset_hz = 0,
+        double amplitude = 1.0);
     ~packet_source_impl();
 
     // Where all the action really happens
@@ -0,0 +1,101 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "packet_timer.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+double wall_time()
+{
+    using namespace std::chrono;
+    return duration<double>(system_clock::now().time_since_epoch()).count();
+}
+
+int bucket_of(std::chrono::steady_clock::duration latency)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency);
+    uint64_t value = us.count() > 0 ? (uint64_t)us.count() : 0;
+
+    int bucket = 0;
+    while (value && bucket < packet_timer::bucket_count - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+}
+
+constexpr int packet_timer::bucket_count;
+constexpr size_t packet_timer::max_calls;
+
+packet_timer::packet_timer()
+{
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    arrived(0);
+}
+
+void packet_timer::arrived(uint64_t sample)
+{
+    if (calls.size() == max_calls) {
+        calls.pop_front();
+    }
+    const packet_arrival now{ std::chrono::steady_clock::now(), wall_time() };
+    calls.push_back({ sample, now });
+}
+
+packet_arrival packet_timer::arrival_of(uint64_t sample)
+{
+    while (calls.size() > 1 && calls[1].sample <= sample) {
+        calls.pop_front();
+    }
+    return calls.front().at;
+}
+
+packet_timing packet_timer::published(const packet_arrival& arrival)
+{
+    auto latency = std::chrono::steady_clock::now() - arrival.time;
+    buckets[bucket_of(latency)].fetch_add(1, std::memory_order_relaxed);
+
+    packet_timing result;
+    result.sample_time = arrival.wall;
+    result.publish_time =
+      arrival.wall + std::chrono::duration<double>(latency).count();
+    return result;
+}
+
+std::vector<uint64_t> packet_timer::histogram() const
+{
+    std::vector<uint64_t> result;
+    result.reserve(bucket_count);
+    for (auto& bucket : buckets) {
+        result.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    return result;
+}
@@ -0,0 +1,111 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_TIMER_H
+#define INCLUDED_OOK_PACKET_TIMER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/* Wall-clock times attached to a published packet, in seconds. */
+struct packet_timing {
+    double sample_time;
+    double publish_time;
+};
+
+/* When a work call started, on both clocks. */
+struct packet_arrival {
+    std::chrono::steady_clock::time_point time;
+    double wall;
+};
+
+/*
+ * Measures how long packets wait between the arrival of the samples
+ * that complete them and their publication. A decoder may hold samples
+ * back, as the sync correlator does, or complete a packet when it is
+ * flushed, so the samples need not have come in the work call that
+ * publishes the packet. The start of each recent work call is kept
+ * with the index of its first sample, and a packet's arrival is the
+ * start of the call that brought its last sample. Only the last
+ * max_calls calls are kept; older packets are timed from the oldest.
+ *
+ * The latencies go into a histogram of power-of-two buckets: bucket 0
+ * counts latencies under 1us, bucket i counts [2^(i-1), 2^i) us and
+ * the last bucket also takes everything longer. The histogram may be
+ * read from any thread.
+ */
+class packet_timer
+{
+  public:
+    static constexpr int bucket_count = 32;
+    static constexpr size_t max_calls = 4096;
+
+    packet_timer();
+
+    /* Call at the start of each work call; its input starts at 'sample'. */
+    void arrived(std::uint64_t sample);
+
+    /* When the current work call started. */
+    std::chrono::steady_clock::time_point arrival_time() const
+    {
+        return calls.back().at.time;
+    }
+
+    /* The arrival of the current work call. */
+    packet_arrival arrival() const
+    {
+        return calls.back().at;
+    }
+
+    /*
+     * The arrival of the work call that brought 'sample'. Look packets
+     * up in order: calls before the one found are forgotten.
+     */
+    packet_arrival arrival_of(std::uint64_t sample);
+
+    /* Record a packet published now and return its timestamps. */
+    packet_timing published(const packet_arrival& arrival);
+
+    std::vector<std::uint64_t> histogram() const;
+
+  private:
+    struct call {
+        std::uint64_t sample;
+        packet_arrival at;
+    };
+    std::deque<call> calls;
+
+    std::atomic<std::uint64_t> buckets[bucket_count];
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_TIMER_H */
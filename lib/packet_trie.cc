@@ -0,0 +1,234 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cctype>
+#include <stdexcept>
+
+#include "packet_trie.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+const int no_node = -1;
+
+int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = (char)tolower(c);
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* Parse hex digits into nibbles, with -1 for wildcards if allowed. */
+std::vector<int> nibbles(const std::string& text, bool wildcards)
+{
+    std::vector<int> result;
+    for (char c : text) {
+        if (isspace((unsigned char)c)) {
+            continue;
+        }
+        if (wildcards && (c == 'x' || c == 'X' || c == '?')) {
+            result.push_back(-1);
+            continue;
+        }
+
+        int digit = hex_digit(c);
+        if (digit < 0) {
+            throw std::invalid_argument("bad packet pattern: " + text);
+        }
+        result.push_back(digit);
+    }
+
+    if (result.size() % 2) {
+        throw std::invalid_argument("odd number of digits: " + text);
+    }
+    return result;
+}
+}
+
+packet_trie::node::node() : match(-1)
+{
+    for (auto& n : next) {
+        n = no_node;
+    }
+}
+
+packet_trie::packet_trie()
+{
+    new_node();
+}
+
+int packet_trie::new_node()
+{
+    nodes.emplace_back();
+    refs.push_back(0);
+    return (int)nodes.size() - 1;
+}
+
+int packet_trie::clone_node(int index)
+{
+    int result = new_node();
+    nodes[result] = nodes[index];
+    for (int child : nodes[result].next) {
+        if (child != no_node) {
+            refs[child]++;
+        }
+    }
+    return result;
+}
+
+void packet_trie::insert(
+  int index,
+  size_t depth,
+  const std::vector<uint8_t>& value,
+  const std::vector<uint8_t>& mask,
+  int pattern)
+{
+    if (depth == value.size()) {
+        if (nodes[index].match < 0 || pattern < nodes[index].match) {
+            nodes[index].match = pattern;
+        }
+        return;
+    }
+
+    const uint8_t m = mask[depth];
+    const uint8_t v = value[depth] & m;
+
+    /*
+     * Give every accepted edge a node of its own for this pattern,
+     * handling edges that currently lead to the same node together so
+     * they keep sharing one.
+     */
+    bool done[256] = {};
+    for (int b = 0; b < 256; ++b) {
+        if (done[b] || (b & m) != v) {
+            continue;
+        }
+
+        const int old_child = nodes[index].next[b];
+        int edges = 0;
+        for (int c = b; c < 256; ++c) {
+            if ((c & m) == v && nodes[index].next[c] == old_child) {
+                edges++;
+            }
+        }
+
+        int child;
+        if (old_child == no_node) {
+            child = new_node();
+        } else if (edges == refs[old_child]) {
+            child = old_child;
+        } else {
+            child = clone_node(old_child);
+        }
+
+        for (int c = b; c < 256; ++c) {
+            if ((c & m) == v && nodes[index].next[c] == old_child) {
+                nodes[index].next[c] = child;
+                done[c] = true;
+            }
+        }
+        if (child != old_child) {
+            refs[child] += edges;
+            if (old_child != no_node) {
+                refs[old_child] -= edges;
+            }
+        }
+
+        insert(child, depth + 1, value, mask, pattern);
+    }
+}
+
+int packet_trie::add(
+  const std::vector<uint8_t>& value,
+  const std::vector<uint8_t>& mask)
+{
+    if (value.size() != mask.size()) {
+        throw std::invalid_argument("pattern and mask lengths differ");
+    }
+
+    int pattern = patterns++;
+    insert(0, 0, value, mask, pattern);
+    return pattern;
+}
+
+int packet_trie::match(const uint8_t* data, size_t size) const
+{
+    int best = nodes[0].match;
+    int index = 0;
+    for (size_t i = 0; i < size; ++i) {
+        index = nodes[index].next[data[i]];
+        if (index == no_node) {
+            break;
+        }
+
+        int m = nodes[index].match;
+        if (m >= 0 && (best < 0 || m < best)) {
+            best = m;
+        }
+    }
+    return best;
+}
+
+void packet_trie::parse_pattern(
+  const std::string& text,
+  std::vector<uint8_t>& value,
+  std::vector<uint8_t>& mask)
+{
+    auto slash = text.find('/');
+    auto digits = nibbles(text.substr(0, slash), true);
+
+    value.assign(digits.size() / 2, 0);
+    mask.assign(digits.size() / 2, 0);
+    for (size_t i = 0; i < digits.size(); ++i) {
+        if (digits[i] < 0) {
+            continue;
+        }
+        const int shift = (i % 2) ? 0 : 4;
+        value[i / 2] |= digits[i] << shift;
+        mask[i / 2] |= 0xf << shift;
+    }
+
+    if (slash != std::string::npos) {
+        auto explicit_mask = nibbles(text.substr(slash + 1), false);
+        if (explicit_mask.size() != digits.size()) {
+            throw std::invalid_argument("mask length differs: " + text);
+        }
+        for (size_t i = 0; i < explicit_mask.size(); ++i) {
+            const int shift = (i % 2) ? 0 : 4;
+            mask[i / 2] &= ~((0xf & ~explicit_mask[i]) << shift);
+        }
+    }
+
+    for (size_t i = 0; i < value.size(); ++i) {
+        value[i] &= mask[i];
+    }
+}
@@ -0,0 +1,103 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_PACKET_TRIE_H
+#define INCLUDED_OOK_PACKET_TRIE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Matches packet payloads against a set of masked byte prefixes.
+ *
+ * The patterns are compiled into a deterministic automaton with one
+ * 256-way table per node, so a lookup is one table step per payload
+ * byte whatever the number of patterns. A byte position that a pattern
+ * masks entirely or in part fans out to every byte value it accepts;
+ * those edges share a node, which is only copied when a later pattern
+ * needs to tell them apart.
+ */
+class packet_trie
+{
+  public:
+    packet_trie();
+
+    /*
+     * Add a pattern and return its index. Earlier patterns win when
+     * several match. 'value' and 'mask' have the same length; a payload
+     * matches if its first bytes agree with 'value' wherever 'mask' has
+     * bits set.
+     */
+    int add(
+      const std::vector<uint8_t>& value,
+      const std::vector<uint8_t>& mask);
+
+    /* The first pattern that matches, or -1. */
+    int match(const uint8_t* data, size_t size) const;
+
+    size_t node_count() const
+    {
+        return nodes.size();
+    }
+
+    /*
+     * Parse "<hex>[/<hex mask>]" into value and mask. In the value, an
+     * 'x' or '?' digit matches any nibble; spaces are ignored. Throws
+     * std::invalid_argument on malformed input.
+     */
+    static void parse_pattern(
+      const std::string& text,
+      std::vector<uint8_t>& value,
+      std::vector<uint8_t>& mask);
+
+  private:
+    struct node {
+        node();
+        int next[256];
+        int match;
+    };
+
+    std::vector<node> nodes;
+    std::vector<int> refs;
+    int patterns = 0;
+
+    int new_node();
+    int clone_node(int index);
+    void insert(
+      int index,
+      size_t depth,
+      const std::vector<uint8_t>& value,
+      const std::vector<uint8_t>& mask,
+      int pattern);
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_PACKET_TRIE_H */
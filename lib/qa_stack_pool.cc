@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "qa_stack_pool.h"
+#include "stack_pool.h"
+
+using namespace gr::ook::util;
+
+void qa_stack_pool::t_reuse()
+{
+    auto& pool = stack_pool::instance();
+    const size_t page = sysconf(_SC_PAGESIZE);
+
+    stack_pool::stack first = pool.acquire(page + 1);
+    CPPUNIT_ASSERT(first.base != nullptr);
+    CPPUNIT_ASSERT_EQUAL(2 * page, first.size);
+    pool.release(first);
+
+    /* Any request that rounds to the same size gets the released stack. */
+    stack_pool::stack again = pool.acquire(2 * page);
+    CPPUNIT_ASSERT_EQUAL((void*)first.base, (void*)again.base);
+    CPPUNIT_ASSERT_EQUAL(first.size, again.size);
+
+    /* Other sizes have their own free lists. */
+    stack_pool::stack other = pool.acquire(page);
+    CPPUNIT_ASSERT(other.base != again.base);
+    CPPUNIT_ASSERT_EQUAL(page, other.size);
+
+    pool.release(again);
+    pool.release(other);
+}
+
+void qa_stack_pool::t_default_size()
+{
+    /* Nothing else in this test reads the size, so it is not cached yet. */
+    setenv("OOK_COROUTINE_STACK_SIZE", "0x6000", 0);
+    const size_t expected =
+      strtoul(getenv("OOK_COROUTINE_STACK_SIZE"), nullptr, 0);
+    CPPUNIT_ASSERT_EQUAL(expected ? expected : 1 << 14,
+                         stack_pool::default_size());
+}
+
+void qa_stack_pool::t_guard_page()
+{
+    auto& pool = stack_pool::instance();
+    stack_pool::stack s = pool.acquire(stack_pool::default_size());
+
+    /* Overflowing the stack must fault, so write below it in a child. */
+    pid_t child = fork();
+    CPPUNIT_ASSERT(child >= 0);
+    if (child == 0) {
+        s.base[0] = 1;
+        s.base[-1] = 1;
+        _exit(0);
+    }
+    int status = 0;
+    CPPUNIT_ASSERT_EQUAL(child, waitpid(child, &status, 0));
+    CPPUNIT_ASSERT(WIFSIGNALED(status));
+    CPPUNIT_ASSERT_EQUAL(SIGSEGV, WTERMSIG(status));
+
+    pool.release(s);
+}
+
+void qa_stack_pool::t_high_water()
+{
+    auto& pool = stack_pool::instance();
+    debug_enable(debug_flags::stack);
+
+    stack_pool::stack s = pool.acquire(stack_pool::default_size());
+    CPPUNIT_ASSERT_EQUAL((size_t)0, stack_pool::high_water(s));
+
+    /* Stacks grow down, so usage is measured from the top. */
+    memset(s.base + s.size - 100, 0, 100);
+    CPPUNIT_ASSERT_EQUAL((size_t)100, stack_pool::high_water(s));
+
+    /* A reused stack is painted again. */
+    pool.release(s);
+    stack_pool::stack again = pool.acquire(s.size);
+    CPPUNIT_ASSERT_EQUAL((void*)s.base, (void*)again.base);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, stack_pool::high_water(again));
+
+    pool.release(again);
+    debug_enable(debug_flags::none);
+}
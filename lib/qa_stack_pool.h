@@ -0,0 +1,43 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_QA_STACK_POOL_H
+#define INCLUDED_OOK_QA_STACK_POOL_H
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class qa_stack_pool : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(qa_stack_pool);
+    CPPUNIT_TEST(t_reuse);
+    CPPUNIT_TEST(t_default_size);
+    CPPUNIT_TEST(t_guard_page);
+    CPPUNIT_TEST(t_high_water);
+    CPPUNIT_TEST_SUITE_END();
+
+  private:
+    void t_reuse();
+    void t_default_size();
+    void t_guard_page();
+    void t_high_water();
+};
+
+#endif /* INCLUDED_OOK_QA_STACK_POOL_H */
@@ -0,0 +1,368 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rl_capture_writer.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+const char magic[8] = {'O', 'O', 'K', 'R', 'L', 0, 0, 0};
+const uint32_t version = 1;
+
+/* Encoded runs are written out in pieces of about this size. */
+const size_t write_size = 1 << 16;
+
+std::runtime_error io_error(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+bool valid_amplitude_bits(int bits)
+{
+    return bits == 0 || bits == 8 || bits == 16;
+}
+
+void write_all(int fd, const void* data, size_t size, const std::string& path)
+{
+    const char* p = (const char*)data;
+    while (size) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw io_error("cannot write", path);
+        }
+        p += n;
+        size -= n;
+    }
+}
+}
+
+rl_capture_reader::rl_capture_reader(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw io_error("cannot open", path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw io_error("cannot stat", path);
+    }
+
+    length_ = st.st_size;
+    if (length_ < sizeof(rl_capture_header)) {
+        ::close(fd);
+        throw std::runtime_error("not a run-length capture: " + path);
+    }
+
+    void* mapping = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw io_error("cannot map", path);
+    }
+    map_ = (const char*)mapping;
+
+    const auto& h = header();
+    bool valid = memcmp(h.magic, magic, sizeof(magic)) == 0 &&
+                 h.version == version && h.header_size <= length_ &&
+                 valid_amplitude_bits(h.amplitude_bits);
+    if (valid && h.index_offset) {
+        valid = h.header_size + h.data_size <= h.index_offset &&
+                h.index_offset <= length_ &&
+                h.index_count <=
+                  (length_ - h.index_offset) / sizeof(rl_capture_index_entry);
+    }
+    if (!valid) {
+        munmap((void*)map_, length_);
+        throw std::runtime_error("not a run-length capture: " + path);
+    }
+
+    runs_ = (const std::uint8_t*)map_ + h.header_size;
+    if (h.index_offset) {
+        runs_size_ = h.data_size;
+        index_ = map_ + h.index_offset;
+        index_count_ = h.index_count;
+    } else {
+        runs_size_ = length_ - h.header_size;
+    }
+}
+
+rl_capture_reader::~rl_capture_reader()
+{
+    munmap((void*)map_, length_);
+}
+
+const rl_capture_header& rl_capture_reader::header() const
+{
+    return *(const rl_capture_header*)map_;
+}
+
+void rl_capture_reader::seek(std::uint64_t sample)
+{
+    pos_ = 0;
+    sample_ = 0;
+
+    /* The last index entry at or before 'sample'. Entries are unaligned. */
+    size_t lo = 0, hi = index_count_;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        rl_capture_index_entry entry;
+        memcpy(&entry, index_ + mid * sizeof(entry), sizeof(entry));
+        if (entry.sample <= sample) {
+            pos_ = entry.offset;
+            sample_ = entry.sample;
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    rl_capture_run run;
+    while (true) {
+        const size_t pos = pos_;
+        const std::uint64_t start = sample_;
+        if (!next(run)) {
+            return;
+        }
+        if (run.start_sample + run.duration > sample) {
+            pos_ = pos;
+            sample_ = start;
+            return;
+        }
+    }
+}
+
+bool rl_capture_reader::next(rl_capture_run& run)
+{
+    const auto& h = header();
+    size_t pos = pos_;
+    std::uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        if (pos == runs_size_) {
+            return false;
+        }
+        if (shift > 63) {
+            throw std::runtime_error("corrupt run-length capture");
+        }
+        const std::uint8_t byte = runs_[pos++];
+        value |= (std::uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    const size_t code_size = h.amplitude_bits / 8;
+    if (runs_size_ - pos < code_size) {
+        return false;
+    }
+    if (value < 2) {
+        throw std::runtime_error("corrupt run-length capture");
+    }
+
+    run.start_sample = sample_;
+    run.duration = value >> 1;
+    run.level = value & 1;
+    if (code_size) {
+        unsigned code = runs_[pos];
+        if (code_size == 2) {
+            code |= (unsigned)runs_[pos + 1] << 8;
+        }
+        run.amplitude =
+          code * h.full_scale / (float)((1u << h.amplitude_bits) - 1);
+    } else {
+        run.amplitude = run.level ? h.full_scale : 0.0f;
+    }
+
+    pos_ = pos + code_size;
+    sample_ += run.duration;
+    return true;
+}
+
+rl_capture_writer::rl_capture_writer(
+  const std::string& path_,
+  double sample_rate,
+  float threshold,
+  float full_scale,
+  int amplitude_bits) :
+    path(path_),
+    header{}
+{
+    if (!valid_amplitude_bits(amplitude_bits)) {
+        throw std::invalid_argument(
+          "run-length capture amplitude_bits must be 0, 8 or 16");
+    }
+    if (!(full_scale > 0)) {
+        throw std::invalid_argument(
+          "run-length capture full_scale must be positive");
+    }
+
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.header_size = sizeof(rl_capture_header);
+    header.sample_rate = sample_rate;
+    header.threshold = threshold;
+    header.full_scale = full_scale;
+    header.amplitude_bits = (std::uint8_t)amplitude_bits;
+
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw io_error("cannot create", path);
+    }
+    write_all(fd, &header, sizeof(header), path);
+    buffer.reserve(write_size + 16);
+}
+
+rl_capture_writer::~rl_capture_writer()
+{
+    try {
+        close();
+    } catch (const std::exception&) {
+        /* Nothing to report to; the file reads as unfinished. */
+    }
+}
+
+void rl_capture_writer::add(bool level_, std::uint64_t duration_, double sum_)
+{
+    if (!duration_) {
+        return;
+    }
+    if (fd < 0) {
+        reopen();
+    }
+    if (duration && level_ != level) {
+        encode_pending();
+    }
+    level = level_;
+    duration += duration_;
+    sum += sum_;
+}
+
+void rl_capture_writer::reopen()
+{
+    fd = open(path.c_str(), O_WRONLY);
+    if (fd < 0) {
+        throw io_error("cannot reopen", path);
+    }
+
+    /*
+     * Mark the capture unfinished and drop the index; close() writes
+     * both again after the new runs.
+     */
+    const off_t end = header.header_size + header.data_size;
+    header.index_offset = 0;
+    header.index_count = 0;
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        ftruncate(fd, end) != 0 || lseek(fd, end, SEEK_SET) != end) {
+        ::close(fd);
+        fd = -1;
+        throw io_error("cannot reopen", path);
+    }
+}
+
+void rl_capture_writer::encode_pending()
+{
+    const std::uint64_t start = header.sample_count;
+    if (index.empty() ||
+        start >= (index.back().sample / rl_capture_index_interval + 1) *
+                   rl_capture_index_interval) {
+        index.push_back({ start, header.data_size + buffer.size() });
+    }
+
+    std::uint64_t value = duration << 1 | (level ? 1 : 0);
+    while (value >= 0x80) {
+        buffer.push_back((std::uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((std::uint8_t)value);
+
+    if (header.amplitude_bits) {
+        const unsigned max_code = (1u << header.amplitude_bits) - 1;
+        const double mean = sum / duration / header.full_scale;
+        const unsigned code = (unsigned)std::lround(
+          std::min(std::max(mean, 0.0), 1.0) * max_code);
+        buffer.push_back((std::uint8_t)code);
+        if (header.amplitude_bits == 16) {
+            buffer.push_back((std::uint8_t)(code >> 8));
+        }
+    }
+
+    header.sample_count += duration;
+    header.run_count++;
+    duration = 0;
+    sum = 0;
+
+    if (buffer.size() >= write_size) {
+        write_buffer();
+    }
+}
+
+void rl_capture_writer::write_buffer()
+{
+    write_all(fd, buffer.data(), buffer.size(), path);
+    header.data_size += buffer.size();
+    buffer.clear();
+}
+
+void rl_capture_writer::close()
+{
+    if (fd < 0) {
+        return;
+    }
+
+    if (duration) {
+        encode_pending();
+    }
+    write_buffer();
+    write_all(
+      fd, index.data(), index.size() * sizeof(rl_capture_index_entry), path);
+
+    header.index_offset = header.header_size + header.data_size;
+    header.index_count = index.size();
+    /*
+     * If the header cannot be updated, drop the index so that the
+     * capture reads back as an unfinished one.
+     */
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header) &&
+        ftruncate(fd, header.index_offset) != 0) {
+        /* Nothing more can be done. */
+    }
+    ::close(fd);
+    fd = -1;
+}
@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <cmath>
+
+#include "rl_capture_sink_impl.h"
+
+namespace gr
+{
+namespace ook
+{
+rl_capture_sink::sptr rl_capture_sink::make(
+  const std::string& path,
+  double threshold,
+  double sample_rate,
+  int amplitude_bits,
+  double full_scale)
+{
+    return gnuradio::get_initial_sptr(new rl_capture_sink_impl(
+      path, threshold, sample_rate, amplitude_bits, full_scale));
+}
+
+/*
+ * The private constructor
+ */
+rl_capture_sink_impl::rl_capture_sink_impl(
+  const std::string& path,
+  double threshold,
+  double sample_rate,
+  int amplitude_bits,
+  double full_scale)
+    : gr::sync_block(
+        "rl_capture_sink",
+        gr::io_signature::make(1, 1, sizeof(float)),
+        gr::io_signature::make(0, 0, 0)),
+      slicer_((float)threshold),
+      writer_(
+        path,
+        sample_rate,
+        (float)threshold,
+        (float)full_scale,
+        amplitude_bits),
+      amplitudes_(amplitude_bits != 0)
+{
+}
+
+/*
+ * Our virtual destructor.
+ */
+rl_capture_sink_impl::~rl_capture_sink_impl()
+{
+}
+
+bool rl_capture_sink_impl::stop()
+{
+    writer_.close();
+    return true;
+}
+
+int rl_capture_sink_impl::work(
+  int noutput_items,
+  gr_vector_const_void_star& input_items,
+  gr_vector_void_star& output_items)
+{
+    const float* in = (const float*)input_items[0];
+    if (runs_.size() < (size_t)noutput_items) {
+        runs_.resize(noutput_items);
+    }
+
+    int nruns;
+    if (amplitudes_) {
+        if (sums_.size() < (size_t)noutput_items) {
+            sums_.resize(noutput_items);
+        }
+        nruns = slicer_.slice(in, noutput_items, runs_.data(), sums_.data());
+    } else {
+        nruns = slicer_.slice(in, noutput_items, runs_.data());
+    }
+
+    for (int i = 0; i < nruns; ++i) {
+        writer_.add(
+          run_level(runs_[i]),
+          (uint64_t)std::lround(run_duration(runs_[i])),
+          amplitudes_ ? sums_[i].sum : 0);
+    }
+
+    return noutput_items;
+}
+
+} /* namespace ook */
+} /* namespace gr */
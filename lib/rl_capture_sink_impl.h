@@ -0,0 +1,64 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_OOK_RL_CAPTURE_SINK_IMPL_H
+#define INCLUDED_OOK_RL_CAPTURE_SINK_IMPL_H
+
+#include <ook/rl_capture_sink.h>
+#include <vector>
+
+#include "rl_capture_writer.h"
+#include "slicer.h"
+
+namespace gr
+{
+namespace ook
+{
+class rl_capture_sink_impl : public rl_capture_sink
+{
+  private:
+    util::slicer<float> slicer_;
+    util::rl_capture_writer writer_;
+    const bool amplitudes_;
+    std::vector<run_t> runs_;
+    std::vector<util::run_sums> sums_;
+
+  public:
+    rl_capture_sink_impl(
+      const std::string& path,
+      double threshold,
+      double sample_rate,
+      int amplitude_bits,
+      double full_scale);
+    ~rl_capture_sink_impl();
+
+    bool stop();
+
+    int work(
+      int noutput_items,
+      gr_vector_const_void_star& input_items,
+      gr_vector_void_star& output_items);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RL_CAPTURE_SINK_IMPL_H */
@@ -0,0 +1,125 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <ook/run.h>
+#include <algorithm>
+
+#include "rl_capture_source_impl.h"
+
+namespace
+{
+/* The longest run written as one item; floats hold it exactly. */
+const std::uint64_t max_piece = 1 << 24;
+}
+
+namespace gr
+{
+namespace ook
+{
+rl_capture_source::sptr rl_capture_source::make(
+  const std::string& path,
+  bool envelope,
+  std::uint64_t start_sample)
+{
+    return gnuradio::get_initial_sptr(
+      new rl_capture_source_impl(path, envelope, start_sample));
+}
+
+/*
+ * The private constructor
+ */
+rl_capture_source_impl::rl_capture_source_impl(
+  const std::string& path,
+  bool envelope,
+  std::uint64_t start_sample)
+    : gr::sync_block(
+        "rl_capture_source",
+        gr::io_signature::make(0, 0, 0),
+        gr::io_signature::make(
+          1, 1, envelope ? sizeof(float) : sizeof(run_t))),
+      reader_(path),
+      envelope_(envelope),
+      start_sample_(start_sample),
+      run_(),
+      remaining_(0)
+{
+    reader_.seek(start_sample);
+}
+
+/*
+ * Our virtual destructor.
+ */
+rl_capture_source_impl::~rl_capture_source_impl()
+{
+}
+
+bool rl_capture_source_impl::next_run()
+{
+    if (remaining_) {
+        return true;
+    }
+    if (!reader_.next(run_)) {
+        return false;
+    }
+
+    /* Only the run that contains start_sample starts before it. */
+    remaining_ = run_.start_sample + run_.duration -
+                 std::max(run_.start_sample, start_sample_);
+    return true;
+}
+
+int rl_capture_source_impl::work(
+  int noutput_items,
+  gr_vector_const_void_star& input_items,
+  gr_vector_void_star& output_items)
+{
+    int produced = 0;
+    if (envelope_) {
+        float* out = (float*)output_items[0];
+        while (produced < noutput_items && next_run()) {
+            const int n = (int)std::min<std::uint64_t>(
+              remaining_, noutput_items - produced);
+            std::fill(out + produced, out + produced + n, run_.amplitude);
+            produced += n;
+            remaining_ -= n;
+        }
+    } else {
+        run_t* out = (run_t*)output_items[0];
+        while (produced < noutput_items && next_run()) {
+            const std::uint64_t piece = std::min(remaining_, max_piece);
+            out[produced++] = make_run(run_.level, (float)piece);
+            remaining_ -= piece;
+        }
+    }
+
+    if (!produced) {
+        return -1;
+    }
+    return produced;
+}
+
+} /* namespace ook */
+} /* namespace gr */
@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 <+YOU OR YOUR COMPANY+>.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_OOK_RL_CAPTURE_SOURCE_IMPL_H
+#define INCLUDED_OOK_RL_CAPTURE_SOURCE_IMPL_H
+
+#include <ook/rl_capture.h>
+#include <ook/rl_capture_source.h>
+
+namespace gr
+{
+namespace ook
+{
+class rl_capture_source_impl : public rl_capture_source
+{
+  private:
+    rl_capture_reader reader_;
+    const bool envelope_;
+    const std::uint64_t start_sample_;
+
+    /* The run being written and how many of its samples are left. */
+    rl_capture_run run_;
+    std::uint64_t remaining_;
+
+    /* Move on to the next run if this one is done; false at the end. */
+    bool next_run();
+
+  public:
+    rl_capture_source_impl(
+      const std::string& path,
+      bool envelope,
+      std::uint64_t start_sample);
+    ~rl_capture_source_impl();
+
+    int work(
+      int noutput_items,
+      gr_vector_const_void_star& input_items,
+      gr_vector_void_star& output_items);
+};
+
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RL_CAPTURE_SOURCE_IMPL_H */
@@ -0,0 +1,88 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_RL_CAPTURE_WRITER_H
+#define INCLUDED_OOK_RL_CAPTURE_WRITER_H
+
+#include <ook/rl_capture.h>
+#include <ook/run.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Writes a run-length capture (see ook/rl_capture.h). Runs are added in
+ * the pieces a slicer flushes them in and merged until the level
+ * changes, then encoded into a buffer that goes to the file in large
+ * writes. close() writes the last run, the index and the final header.
+ * An existing file at 'path' is replaced. Runs added after close()
+ * reopen the file and extend the same capture.
+ */
+class rl_capture_writer
+{
+  public:
+    rl_capture_writer(
+      const std::string& path,
+      double sample_rate,
+      float threshold,
+      float full_scale,
+      int amplitude_bits);
+    ~rl_capture_writer();
+
+    rl_capture_writer(const rl_capture_writer&) = delete;
+    rl_capture_writer& operator=(const rl_capture_writer&) = delete;
+
+    /*
+     * Add 'duration' samples at 'level' whose envelope sums to 'sum'.
+     * The sum is only used with amplitude codes.
+     */
+    void add(bool level, std::uint64_t duration, double sum);
+
+    void close();
+
+  private:
+    void reopen();
+    void encode_pending();
+    void write_buffer();
+
+    const std::string path;
+    rl_capture_header header;
+    int fd = -1;
+    std::vector<std::uint8_t> buffer;
+    std::vector<rl_capture_index_entry> index;
+
+    /* The run being merged. */
+    bool level = false;
+    std::uint64_t duration = 0;
+    double sum = 0;
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_RL_CAPTURE_WRITER_H */
@@ -0,0 +1,166 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+
+#include "packet_pmt.h"
+#include "run_decoder_impl.h"
+
+namespace
+{
+const pmt::pmt_t packet_sym = pmt::mp("packet");
+const pmt::pmt_t packets_sym = pmt::mp("packets");
+}
+
+namespace gr
+{
+namespace ook
+{
+run_decoder::sptr run_decoder::make(
+  double tolerance,
+  bool timestamps,
+  const std::vector<int>& expected_bits,
+  bool learn_lengths,
+  double sample_rate,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count,
+  int batch_size,
+  double batch_timeout_ms)
+{
+    return gnuradio::get_initial_sptr(new run_decoder_impl(
+      tolerance,
+      timestamps,
+      expected_bits,
+      learn_lengths,
+      sample_rate,
+      min_width_us,
+      max_width_us,
+      min_sync_count,
+      batch_size,
+      batch_timeout_ms));
+}
+
+/*
+ * The private constructor
+ */
+run_decoder_impl::run_decoder_impl(
+  double tolerance,
+  bool timestamps,
+  const std::vector<int>& expected_bits,
+  bool learn_lengths,
+  double sample_rate,
+  double min_width_us,
+  double max_width_us,
+  int min_sync_count,
+  int batch_size,
+  double batch_timeout_ms)
+    : gr::block(
+        "run_decoder",
+        gr::io_signature::make(1, 1, sizeof(run_t)),
+        gr::io_signature::make(0, 0, 0)),
+      reader_(tolerance),
+      timestamps_(timestamps),
+      batch_(batch_size, batch_timeout_ms)
+{
+    reader_.expect_lengths(expected_bits, learn_lengths);
+    reader_.set_limits(
+      sample_rate, min_width_us, max_width_us, min_sync_count);
+    message_port_register_out(packet_sym);
+    message_port_register_out(packets_sym);
+}
+
+/*
+ * Our virtual destructor.
+ */
+run_decoder_impl::~run_decoder_impl()
+{
+}
+
+std::vector<std::uint64_t> run_decoder_impl::latency_histogram() const
+{
+    return timer_.histogram();
+}
+
+bool run_decoder_impl::stop()
+{
+    if (!batch_.empty()) {
+        publish_batch();
+    }
+    return true;
+}
+
+void run_decoder_impl::publish_packets()
+{
+    const auto now = timer_.arrival_time();
+    while (reader_.has_packet()) {
+        auto packet = reader_.next_packet();
+        auto message = util::packet_to_pmt(packet);
+
+        if (batch_.enabled()) {
+            if (batch_.add(message, timer_.arrival(), now)) {
+                publish_batch();
+            }
+            continue;
+        }
+
+        auto timing = timer_.published(timer_.arrival());
+        message_port_pub(
+          packet_sym,
+          timestamps_ ? util::add_timing(message, timing) : message);
+    }
+
+    if (batch_.expired(now)) {
+        publish_batch();
+    }
+}
+
+void run_decoder_impl::publish_batch()
+{
+    message_port_pub(packets_sym, batch_.take(timer_, timestamps_));
+}
+
+void run_decoder_impl::forecast(
+  int noutput_items,
+  gr_vector_int& ninput_items_required)
+{
+}
+
+int run_decoder_impl::general_work(
+  int noutput_items,
+  gr_vector_int& ninput_items,
+  gr_vector_const_void_star& input_items,
+  gr_vector_void_star& output_items)
+{
+    /* Runs complete packets as they come, so no sample lookup is needed. */
+    timer_.arrived(nitems_read(0));
+    reader_.resume((const run_t*)input_items[0], ninput_items[0]);
+    publish_packets();
+
+    consume_each(ninput_items[0]);
+    return 0;
+}
+
+} /* namespace ook */
+} /* namespace gr */
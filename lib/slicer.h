@@ -0,0 +1,208 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_SLICER_H
+#define INCLUDED_OOK_SLICER_H
+
+#include <ook/run.h>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/* The sum and sum of squares of the samples of one run. */
+struct run_sums {
+    double sum;
+    double squares;
+};
+
+/*
+ * Slices an envelope against a threshold into runs. A sample exactly at
+ * the threshold keeps the previous level. The run in progress at the end
+ * of each call is flushed, so the output never lags the input; the next
+ * call may continue it with another run at the same level.
+ *
+ * Run durations are whole samples unless the slicer interpolates. Then
+ * each edge is placed where the straight line between the samples on
+ * either side crosses the threshold, so durations have fractions. An
+ * edge can then fall up to half a sample before the first sample of a
+ * call. Each call therefore only flushes up to half a sample before its
+ * end, and every position is late by that half sample.
+ */
+template <class T>
+class slicer
+{
+  private:
+    T threshold;
+    bool level = false;
+    bool interpolate;
+
+    /*
+     * For interpolation: the last sample of the previous call, and where
+     * the unfinished run starts relative to the next call's first sample.
+     */
+    double last = 0;
+    double start_offset = 0;
+
+    /*
+     * Where the signal crosses the threshold between sample i - 1 and
+     * sample i, as a position relative to in[0]. A step exactly halfway
+     * between the samples gives i, as without interpolation.
+     */
+    double crossing(const T* in, int i) const
+    {
+        const double before = i ? (double)in[i - 1] : last;
+        const double step = (double)in[i] - before;
+        double t = step ? ((double)threshold - before) / step : 0.5;
+        t = t < 0 ? 0 : t > 1 ? 1 : t;
+        return i - 0.5 + t;
+    }
+
+    template <bool with_sums, bool interpolated>
+    int slice_runs(const T* in, int n, run_t* out, run_sums* sums)
+    {
+        int count = 0;
+        int length = 0;
+        double start = start_offset;
+        double sum = 0, squares = 0;
+        for (int i = 0; i < n; ++i) {
+            bool next = in[i] > threshold ? true
+                      : in[i] < threshold ? false : level;
+            if (next != level && (interpolated || length)) {
+                double duration = length;
+                if (interpolated) {
+                    const double edge = crossing(in, i);
+                    duration = edge - start;
+                    start = edge;
+                }
+                if (duration > 0) {
+                    if (with_sums) {
+                        sums[count] = { sum, squares };
+                        sum = squares = 0;
+                    }
+                    out[count++] = make_run(level, duration);
+                }
+                length = 0;
+            }
+            level = next;
+            length++;
+            if (with_sums) {
+                sum += in[i];
+                squares += (double)in[i] * in[i];
+            }
+        }
+
+        double duration = length;
+        if (interpolated && n) {
+            duration = n - 0.5 - start;
+            start_offset = -0.5;
+            last = in[n - 1];
+        }
+        if (duration > 0) {
+            if (with_sums) {
+                sums[count] = { sum, squares };
+            }
+            out[count++] = make_run(level, duration);
+        }
+        return count;
+    }
+
+  public:
+    explicit slicer(T threshold_, bool interpolate_ = false) :
+        threshold(threshold_),
+        interpolate(interpolate_)
+    {
+    }
+
+    /* Takes effect from the next sample; the level so far is kept. */
+    void set_threshold(T threshold_)
+    {
+        threshold = threshold_;
+    }
+
+    /*
+     * Slice 'n' samples from 'in' into 'out', which must have room for
+     * 'n' runs. Returns the number of runs written.
+     */
+    int slice(const T* in, int n, run_t* out)
+    {
+        return interpolate ? slice_runs<false, true>(in, n, out, nullptr)
+                           : slice_runs<false, false>(in, n, out, nullptr);
+    }
+
+    /* As above, also summing each run's samples into 'sums'. */
+    int slice(const T* in, int n, run_t* out, run_sums* sums)
+    {
+        return interpolate ? slice_runs<true, true>(in, n, out, sums)
+                           : slice_runs<true, false>(in, n, out, sums);
+    }
+
+    /*
+     * Slice 'n' samples of what is expected to be an idle span, looking
+     * only at every 'stride'th sample and the last one. If the slicer is
+     * low and none of those is high, the span becomes a single low run
+     * in 'out' and 1 is returned. Otherwise 0 is returned and the span
+     * should be sliced in full. Pulses narrower than 'stride' may be
+     * missed.
+     */
+    int skip_idle(const T* in, int n, int stride, run_t* out)
+    {
+        if (level || n == 0 || in[n - 1] > threshold) {
+            return 0;
+        }
+        for (int i = stride - 1; i < n; i += stride) {
+            if (in[i] > threshold) {
+                return 0;
+            }
+        }
+
+        return force_low(in, n, out);
+    }
+
+    /*
+     * Take 'n' samples as low without comparing them, as for input that
+     * a squelch has found idle. Writes one low run to 'out' and returns
+     * 1, or returns 0 if 'n' is zero.
+     */
+    int force_low(const T* in, int n, run_t* out)
+    {
+        if (n == 0) {
+            return 0;
+        }
+
+        level = false;
+        if (interpolate) {
+            out[0] = make_run(false, n - start_offset - 0.5);
+            start_offset = -0.5;
+            last = in[n - 1];
+        } else {
+            out[0] = make_run(false, n);
+        }
+        return 1;
+    }
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_SLICER_H */
@@ -0,0 +1,178 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_SQUELCH_H
+#define INCLUDED_OOK_SQUELCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/* The sum of the squares of 'n' samples. */
+template <class T>
+double sum_squares(const T* in, int n)
+{
+    int64_t sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += (int32_t)in[i] * in[i];
+    }
+    return (double)sum;
+}
+
+/* Vectorized with the widest instruction set enabled at build time. */
+template <>
+double sum_squares<float>(const float* in, int n);
+
+/*
+ * An energy squelch that sorts an envelope into spans to slice and idle
+ * spans that can be taken as low without looking at each sample.
+ *
+ * The power is estimated over blocks of 'block' samples. A block whose
+ * mean square reaches level^2 opens the gate, and the gate closes again
+ * once the power has stayed below half that (3 dB lower) for 'hang'
+ * samples. While the gate is closed the last 'preroll' samples are held
+ * back, so that when it opens they are sliced along with the block that
+ * opened it and the start of the first pulse is not lost. Idle spans
+ * therefore lag the input by up to 'preroll' samples.
+ */
+template <class T>
+class squelch
+{
+  public:
+    static constexpr int block = 64;
+    static constexpr int hang = 4 * block;
+    static constexpr int preroll = 2 * block;
+
+    /* 'level' is an RMS level in sample units; 0 disables the squelch. */
+    explicit squelch(double level) :
+        open_power(level * level),
+        close_power(level * level / 2),
+        held(preroll)
+    {
+    }
+
+    bool enabled() const
+    {
+        return open_power > 0;
+    }
+
+    /*
+     * Sort 'n' samples into spans, calling 'emit(samples, count, idle)'
+     * for each in order. Spans that are not idle may start in the
+     * pre-roll buffer rather than in 'in'.
+     */
+    template <class Emit>
+    void process(const T* in, int n, Emit&& emit)
+    {
+        int pos = 0;
+        while (pos < n) {
+            if (!open) {
+                int s = pos;
+                while (s < n &&
+                       !loud(in + s, std::min(block, n - s), open_power)) {
+                    s += block;
+                }
+                s = std::min(s, n);
+                hold(in + pos, s - pos, emit);
+                if (s == n) {
+                    break;
+                }
+
+                if (held_count) {
+                    emit(held.data(), held_count, false);
+                    held_count = 0;
+                }
+                open = true;
+                quiet = 0;
+                pos = s;
+            } else {
+                int s = pos;
+                while (s < n && open) {
+                    const int length = std::min(block, n - s);
+                    quiet = loud(in + s, length, close_power) ? 0
+                                                             : quiet + length;
+                    s += length;
+                    open = quiet < hang;
+                }
+                emit(in + pos, s - pos, false);
+                pos = s;
+            }
+        }
+    }
+
+  private:
+    const double open_power;
+    const double close_power;
+    bool open = false;
+    int quiet = 0;
+
+    std::vector<T> held;
+    int held_count = 0;
+
+    bool loud(const T* in, int n, double power) const
+    {
+        return sum_squares(in, n) >= power * n;
+    }
+
+    /* Pass on all but the last 'preroll' of the held and new samples. */
+    template <class Emit>
+    void hold(const T* in, int n, Emit& emit)
+    {
+        const int drop = held_count + n - preroll;
+        if (drop <= 0) {
+            std::copy(in, in + n, held.begin() + held_count);
+            held_count += n;
+            return;
+        }
+
+        const int from_held = std::min(drop, held_count);
+        if (from_held) {
+            emit(held.data(), from_held, true);
+        }
+        if (drop > from_held) {
+            emit(in, drop - from_held, true);
+        }
+
+        const int kept = held_count - from_held;
+        std::copy(
+          held.begin() + from_held, held.begin() + held_count, held.begin());
+        std::copy(in + (drop - from_held), in + n, held.begin() + kept);
+        held_count = preroll;
+    }
+};
+
+template <class T>
+constexpr int squelch<T>::block;
+template <class T>
+constexpr int squelch<T>::hang;
+template <class T>
+constexpr int squelch<T>::preroll;
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_SQUELCH_H */
@@ -0,0 +1,132 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "stack_pool.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+const unsigned char paint = 0xa5;
+
+size_t page_size()
+{
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+size_t round_to_page(size_t size)
+{
+    return (size + page_size() - 1) & ~(page_size() - 1);
+}
+}
+
+stack_pool& stack_pool::instance()
+{
+    /* Never destroyed: blocks may release stacks during static teardown. */
+    static stack_pool* pool = new stack_pool;
+    return *pool;
+}
+
+size_t stack_pool::default_size()
+{
+    static const size_t size = [] {
+        const char* env = getenv("OOK_COROUTINE_STACK_SIZE");
+        size_t result = env ? strtoul(env, nullptr, 0) : 0;
+        return result ? result : (size_t)(1 << 14);
+    }();
+    return size;
+}
+
+stack_pool::stack stack_pool::acquire(size_t size)
+{
+    size = round_to_page(size);
+
+    stack result;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto& pool = free_stacks[size];
+        if (!pool.empty()) {
+            result = pool.back();
+            pool.pop_back();
+        }
+    }
+
+    if (!result.base) {
+        void* mapping = mmap(
+          nullptr,
+          size + page_size(),
+          PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+          -1,
+          0);
+        if (mapping == MAP_FAILED) {
+            throw std::bad_alloc{};
+        }
+
+        /* Stacks grow down, so the guard goes below the usable region. */
+        if (mprotect(mapping, page_size(), PROT_NONE) != 0) {
+            munmap(mapping, size + page_size());
+            throw std::bad_alloc{};
+        }
+
+        result.base = (char*)mapping + page_size();
+        result.size = size;
+        debug(
+          debug_flags::stack,
+          "stack mapped %p (%zu bytes)\n",
+          (void*)result.base,
+          size);
+    }
+
+    if (debugEnabled(debug_flags::stack)) {
+        memset(result.base, paint, result.size);
+    }
+
+    return result;
+}
+
+void stack_pool::release(const stack& s)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    free_stacks[s.size].push_back(s);
+}
+
+size_t stack_pool::high_water(const stack& s)
+{
+    size_t untouched = 0;
+    while (untouched < s.size && (unsigned char)s.base[untouched] == paint) {
+        untouched++;
+    }
+    return s.size - untouched;
+}
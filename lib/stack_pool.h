@@ -0,0 +1,85 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_STACK_POOL_H
+#define INCLUDED_OOK_STACK_POOL_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/*
+ * Hands out mmap'd coroutine stacks, each with a PROT_NONE guard page
+ * below it so that an overflow faults instead of corrupting the heap.
+ * Released stacks are kept on a per-size free list and reused. Pages
+ * are only committed by the kernel once touched, so a stack costs as
+ * much memory as its deepest call chain rather than its full size.
+ *
+ * When stack debugging is enabled (OOK_STACK_DEBUG), stacks are filled
+ * with a known pattern on acquisition so that their high-water mark can
+ * be measured later.
+ */
+class stack_pool
+{
+  public:
+    struct stack {
+        char* base = nullptr; /* lowest usable address */
+        size_t size = 0;      /* usable size in bytes */
+    };
+
+    static stack_pool& instance();
+
+    /*
+     * The stack size used when a coroutine does not ask for one. Taken
+     * from OOK_COROUTINE_STACK_SIZE if set, otherwise 16 KiB.
+     */
+    static size_t default_size();
+
+    /* Get a stack of at least 'size' bytes (rounded up to a page). */
+    stack acquire(size_t size);
+
+    /* Return a stack to the pool. */
+    void release(const stack& s);
+
+    /*
+     * The number of bytes of 's' that have been written since it was
+     * acquired. Only meaningful when stack debugging is enabled.
+     */
+    static size_t high_water(const stack& s);
+
+  private:
+    stack_pool() = default;
+
+    std::mutex lock;
+    std::map<size_t, std::vector<stack>> free_stacks;
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_STACK_POOL_H */
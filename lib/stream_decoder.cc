@@ -0,0 +1,100 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ook/core.h>
+#include <ook/stream_decoder.h>
+
+namespace gr
+{
+namespace ook
+{
+namespace
+{
+core::decoder_config make_config(double tolerance, double threshold)
+{
+    core::decoder_config config;
+    config.settings.tolerance = tolerance;
+    config.settings.threshold = threshold;
+    return config;
+}
+}
+
+struct stream_decoder::impl {
+    std::vector<packet> decoded;
+    core::decoder decoder;
+
+    impl(double tolerance, double threshold) :
+        decoder(
+          make_config(tolerance, threshold),
+          [this](const core::packet_info& info) {
+              decoded.push_back(core::to_packet(info));
+          })
+    {
+    }
+
+    std::vector<packet> drain()
+    {
+        std::vector<packet> result;
+        result.swap(decoded);
+        return result;
+    }
+};
+
+stream_decoder::stream_decoder(double tolerance, double threshold) :
+    impl_(new impl{tolerance, threshold})
+{
+}
+
+stream_decoder::~stream_decoder()
+{
+}
+
+std::vector<packet> stream_decoder::feed(const float* samples, size_t count)
+{
+    impl_->decoder.feed(samples, count);
+    return impl_->drain();
+}
+
+std::vector<packet> stream_decoder::flush()
+{
+    impl_->decoder.flush();
+    return impl_->drain();
+}
+
+std::vector<packet> decode_buffer(
+  const float* samples,
+  size_t count,
+  double tolerance,
+  double threshold)
+{
+    stream_decoder decoder{tolerance, threshold};
+    auto result = decoder.feed(samples, count);
+    for (auto& p : decoder.flush()) {
+        result.push_back(std::move(p));
+    }
+    return result;
+}
+
+} /* namespace ook */
+} /* namespace gr */
@@ -0,0 +1,276 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "sync_correlator.h"
+
+using namespace gr;
+using namespace gr::ook;
+using namespace gr::ook::util;
+
+namespace
+{
+size_t transform_size(size_t longest)
+{
+    size_t n = 2;
+    while (n < 4 * longest) {
+        n *= 2;
+    }
+    return n;
+}
+
+size_t template_length(double width)
+{
+    return (size_t)std::ceil(2 * sync_correlator::periods * width);
+}
+
+/* The conjugated spectrum of the template for pulses of 'width'. */
+std::vector<fft::complex> template_spectrum(const fft& transform, double width)
+{
+    std::vector<fft::complex> result(transform.size());
+    for (size_t i = 0; i < template_length(width); ++i) {
+        result[i] = (int)(i / width) % 2 ? -1.0f : 1.0f;
+    }
+    transform.forward(result.data());
+    for (auto& x : result) {
+        x = std::conj(x);
+    }
+    return result;
+}
+}
+
+constexpr int sync_correlator::periods;
+constexpr int sync_correlator::min_resolution;
+
+sync_correlator::sync_correlator(
+  float threshold,
+  int min_width,
+  int max_width,
+  float min_score) :
+    threshold(threshold),
+    min_score(min_score),
+    decimation(std::max(min_width / min_resolution, 1)),
+    longest(template_length((double)max_width / decimation)),
+    transform(transform_size(longest)),
+    hop(transform.size() - longest + 1),
+    sum(0),
+    summed(0),
+    block(transform.size()),
+    fill(0),
+    block_start(0),
+    spectrum(transform.size()),
+    product(transform.size()),
+    magnitudes(transform.size() + 1),
+    best_score(hop),
+    best_width(hop),
+    state(armed),
+    search_start(0),
+    search_end(0),
+    last_width(0),
+    quiet(0)
+{
+    if (min_width < 1 || max_width < min_width) {
+        throw std::invalid_argument("sync_correlator: bad width range");
+    }
+
+    const double step = 1 + 0.5 / periods;
+    const double max = (double)max_width / decimation;
+    for (double width = (double)min_width / decimation; width < max * step;
+         width *= step) {
+        widths.push_back(std::min(width, max));
+    }
+
+    /*
+     * Both templates are real, so the spectrum of a + ib is A + iB and
+     * the inverse transform of Y(conj(A) + i conj(B)) is the pair of
+     * correlations in its real and imaginary parts.
+     */
+    for (size_t i = 0; i < widths.size(); i += 2) {
+        auto pair = template_spectrum(transform, widths[i]);
+        if (i + 1 < widths.size()) {
+            auto other = template_spectrum(transform, widths[i + 1]);
+            for (size_t k = 0; k < pair.size(); ++k) {
+                pair[k] += fft::complex(-other[k].imag(), other[k].real());
+            }
+        }
+        spectra.push_back(std::move(pair));
+    }
+}
+
+void sync_correlator::process(const float* in, int n)
+{
+    const float scale = 1.0f / decimation;
+    for (int i = 0; i < n; ++i) {
+        sum += in[i];
+        if (++summed < decimation) {
+            continue;
+        }
+
+        block[fill++] = sum * scale;
+        sum = 0;
+        summed = 0;
+
+        if (fill == block.size()) {
+            correlate();
+            advance();
+        }
+    }
+}
+
+void sync_correlator::flush()
+{
+    const std::uint64_t end = block_start + fill;
+    while (block_start < end) {
+        std::fill(block.begin() + fill, block.end(), threshold);
+        correlate();
+        advance();
+    }
+    if (state == searching) {
+        finish_search();
+    }
+    state = armed;
+
+    /*
+     * The padding is not input: pick up again where the input ended,
+     * with the partial decimation sum still open, so later hints stay
+     * on the same sample grid.
+     */
+    block_start = end;
+    fill = 0;
+}
+
+void sync_correlator::advance()
+{
+    std::copy(block.begin() + hop, block.end(), block.begin());
+    fill = fill > hop ? fill - hop : 0;
+    block_start += hop;
+}
+
+std::uint64_t sync_correlator::decided() const
+{
+    return (state == searching ? search_start : block_start) * decimation;
+}
+
+void sync_correlator::correlate()
+{
+    const size_t n = block.size();
+    magnitudes[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const float y = block[i] - threshold;
+        spectrum[i] = y;
+        magnitudes[i + 1] = magnitudes[i] + std::fabs(y);
+    }
+    transform.forward(spectrum.data());
+
+    std::fill(best_score.begin(), best_score.end(), -1.0f);
+    for (size_t pair = 0; pair < spectra.size(); ++pair) {
+        const auto& s = spectra[pair];
+        for (size_t k = 0; k < n; ++k) {
+            const auto y = spectrum[k];
+            product[k] = fft::complex(
+              y.real() * s[k].real() - y.imag() * s[k].imag(),
+              y.real() * s[k].imag() + y.imag() * s[k].real());
+        }
+        transform.inverse(product.data());
+
+        for (size_t w = 2 * pair; w < std::min(2 * pair + 2, widths.size());
+             ++w) {
+            const size_t length = template_length(widths[w]);
+            const bool imag = w % 2;
+            for (size_t k = 0; k < hop; ++k) {
+                const double total = magnitudes[k + length] - magnitudes[k];
+                if (total <= 0) {
+                    continue;
+                }
+                const float score = (imag ? product[k].imag()
+                                          : product[k].real()) / total;
+                if (score > best_score[k]) {
+                    best_score[k] = score;
+                    best_width[k] = widths[w];
+                }
+            }
+        }
+    }
+
+    for (size_t k = 0; k < hop; ++k) {
+        search(block_start + k, best_score[k], best_width[k]);
+    }
+}
+
+void sync_correlator::search(std::uint64_t index, float score, double width)
+{
+    switch (state) {
+    case armed:
+        if (score < min_score) {
+            return;
+        }
+        state = searching;
+        search_start = index;
+        search_end = index + template_length(width);
+        window.clear();
+        break;
+
+    case searching:
+        break;
+
+    case disarmed:
+        quiet = score < min_score / 2 ? quiet + 1 : 0;
+        if (quiet >= 2 * last_width) {
+            state = armed;
+        }
+        return;
+    }
+
+    window.push_back({ index, width, score });
+    if (index + 1 == search_end) {
+        finish_search();
+    }
+}
+
+void sync_correlator::finish_search()
+{
+    /*
+     * Every period of a sync train scores about the same, and the ones
+     * before it fall short by 1/periods each, so report the first
+     * within half of that of the best.
+     */
+    float best = 0;
+    for (const auto& candidate : window) {
+        best = std::max(best, candidate.score);
+    }
+    for (const auto& candidate : window) {
+        if (candidate.score >= best * (1 - 0.5f / periods)) {
+            hints.push_back({ candidate.sample * decimation,
+                              candidate.width * decimation,
+                              candidate.score });
+            last_width = candidate.width;
+            break;
+        }
+    }
+    state = disarmed;
+    quiet = 0;
+}
@@ -0,0 +1,164 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2017 Tim Prince.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OOK_SYNC_CORRELATOR_H
+#define INCLUDED_OOK_SYNC_CORRELATOR_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "fft.h"
+
+namespace gr
+{
+namespace ook
+{
+namespace util
+{
+/* A likely sync train, aligned to the start of one of its pulses. */
+struct sync_hint {
+    std::uint64_t sample;
+    double width;
+    float score;
+};
+
+/*
+ * Finds sync trains by correlating the envelope with templates of
+ * 'periods' sync periods (a high pulse and a low gap of the same width)
+ * for a geometric range of pulse widths. A template drifts half a pulse
+ * out of phase over its length when the width is off by 1/(4 periods),
+ * so neighbouring widths differ by half that.
+ *
+ * The envelope is taken relative to the slicing threshold, so the
+ * templates are zero-mean and levels do not matter. Each correlation is
+ * divided by the sum of the magnitudes under the template, giving a
+ * score of 1 for a clean sync train and around 1/sqrt(length) for
+ * noise. Because every pulse counts, a few corrupted pulses only lower
+ * the score a little.
+ *
+ * The envelope is first averaged down so that the narrowest pulse spans
+ * 'min_resolution' samples; a template may have a fractional width, so
+ * this costs no width resolution. The correlations are then computed
+ * by overlap-save FFT convolution, with two templates per inverse
+ * transform since both results are real.
+ * When the best score reaches 'min_score', the start of the sync train
+ * is looked for over the following template length and reported as a
+ * hint.
+ */
+class sync_correlator
+{
+  public:
+    static constexpr int periods = 8;
+    static constexpr int min_resolution = 4;
+
+    /* 'threshold' is the slicing level; widths are in samples. */
+    sync_correlator(
+      float threshold,
+      int min_width,
+      int max_width,
+      float min_score);
+
+    /* Applies from the next block of samples correlated. */
+    void set_threshold(float threshold_)
+    {
+        threshold = threshold_;
+    }
+
+    /* Correlate the next 'n' samples. */
+    void process(const float* in, int n);
+
+    /*
+     * Correlate the rest of the input as if the threshold level followed
+     * it, and end any search. Samples short of a whole decimation step
+     * are left for the input that follows, if any, which continues at
+     * the same position.
+     */
+    void flush();
+
+    bool has_hint() const
+    {
+        return !hints.empty();
+    }
+
+    sync_hint next_hint()
+    {
+        auto result = hints.front();
+        hints.pop_front();
+        return result;
+    }
+
+    /*
+     * Samples before this index have been searched, and any hint for
+     * them has been given.
+     */
+    std::uint64_t decided() const;
+
+  private:
+    float threshold;
+    const float min_score;
+    /* Widths are in decimated samples from here on. */
+    const int decimation;
+    std::vector<double> widths;
+    size_t longest;
+
+    fft transform;
+    size_t hop;
+    /* Template spectra, conjugated, in pairs. */
+    std::vector<std::vector<fft::complex>> spectra;
+
+    float sum;
+    int summed;
+    /* The averaged envelope; the threshold is taken off when correlating. */
+    std::vector<float> block;
+    size_t fill;
+    std::uint64_t block_start;
+    std::vector<fft::complex> spectrum;
+    std::vector<fft::complex> product;
+    std::vector<double> magnitudes;
+    std::vector<float> best_score;
+    std::vector<double> best_width;
+
+    /*
+     * A search starts when the best score reaches min_score and lasts
+     * one template length. Afterwards the score has to stay below half
+     * of min_score for a sync period before another search can start,
+     * which the troughs between the periods of a sync train never do.
+     */
+    enum { armed, searching, disarmed } state;
+    std::uint64_t search_start;
+    std::uint64_t search_end;
+    /* Candidates, in decimated samples. */
+    std::vector<sync_hint> window;
+    double last_width;
+    int quiet;
+    std::deque<sync_hint> hints;
+
+    void correlate();
+    void advance();
+    void finish_search();
+    void search(std::uint64_t index, float score, double width);
+};
+
+} // namespace util
+} // namespace ook
+} // namespace gr
+
+#endif /* INCLUDED_OOK_SYNC_CORRELATOR_H */
@@ -33,11 +33,13 @@
 #include <fstream>
 
 #include "qa_ook.h"
+#include "qa_stack_pool.h"
 
 CppUnit::TestSuite *
 qa_ook::suite()
 {
   CppUnit::TestSuite *s = new CppUnit::TestSuite("ook");
+  s->addTest(qa_stack_pool::suite());
 
   return s;
 }
@@ -20,17 +20,20 @@
 # The presence of this file turns this directory into a Python package
 
 '''
-This is the GNU Radio SMARTNET module. Place your Python package
-description here (python/__init__.py).
+This is the GNU Radio OOK module.
+
+Besides the flowgraph blocks, ook.decode_buffer and ook.stream_decoder
+decode float32 numpy arrays directly and return packets as dictionaries. ook.packet_log reads the segments
+written by ook.packet_log_sink.
 '''
 from __future__ import unicode_literals
 
-# import swig generated symbols into the smartnet namespace
+# import swig generated symbols into the ook namespace
 try:
     # this might fail if the module is python-only
-    from .smartnet_swig import *
+    from .ook_swig import *
 except ImportError:
     pass
 
 # import any pure python here
-#
+from . import packet_log
@@ -0,0 +1,85 @@
+#
+# Copyright 2017 Tim Prince
+#
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+#
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this software; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+#
+'''
+Read packet log segments written by ook.packet_log_sink.
+
+The segment is mapped read-only and each record's payload is returned as
+a memoryview into the mapping, so iterating a large log copies nothing
+but the fixed-size fields. The layout is documented in ook/packet_log.h.
+'''
+from __future__ import unicode_literals
+
+import collections
+import mmap
+import struct
+
+MAGIC = b'OOKLOG\0\0'
+VERSION = 1
+
+_header = struct.Struct('<8sIIQQ')
+_record = struct.Struct('<QIHBBHHI')
+
+Record = collections.namedtuple(
+    'Record', 'sample_offset bit_count sync_count valid_check data')
+
+
+class reader(object):
+    '''Iterate over the records in one packet log segment.'''
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        magic, version, self._start, used, self._count = \
+            _header.unpack_from(self._map, 0)
+        if magic != MAGIC or version != VERSION or \
+                self._start + used > len(self._map):
+            self._map.close()
+            raise ValueError('not a packet log: %s' % path)
+        self._end = self._start + used
+
+    def __len__(self):
+        return self._count
+
+    def __iter__(self):
+        view = memoryview(self._map)
+        offset = self._start
+        while offset < self._end:
+            (sample_offset, bit_count, sync_count, valid_check, _,
+             payload_size, record_size, _) = \
+                _record.unpack_from(self._map, offset)
+            payload = offset + _record.size
+            yield Record(sample_offset, bit_count, sync_count,
+                         bool(valid_check),
+                         view[payload:payload + payload_size])
+            offset += record_size
+
+    def close(self):
+        self._map.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+
+def read(path):
+    '''Return the records of a packet log segment as a list.'''
+    with reader(path) as r:
+        return [rec._replace(data=bytes(rec.data)) for rec in r]
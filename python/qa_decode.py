@@ -23,12 +23,14 @@ from gnuradio import gr, gr_unittest
 from gnuradio import blocks
 from time import sleep
 import ook_swig as ook
+import packet_log
 
-import os, sys, fnmatch
+import os, sys, fnmatch, glob, shutil, subprocess, tempfile
 from fnmatch import fnmatch
 import pmt
 import json
 import unittest
+import numpy
 from itertools import chain
 
 samples_dir = os.environ['OOK_TEST_SAMPLES_DIR']
@@ -42,6 +44,28 @@ def de_unicode(x):
     return {de_unicode(k) : de_unicode(v) for k, v in x.items()}
   return x
 
+class at_sample (gr.sync_block):
+  # Passes samples through, calling 'action' before sample 'index' goes
+  # out. With a small output buffer, the block downstream has by then
+  # taken all but the last buffer's worth of the samples before it.
+  def __init__ (self, index, action):
+    gr.sync_block.__init__(
+      self, 'at_sample', [numpy.float32], [numpy.float32])
+    self.index = index
+    self.action = action
+    self.sent = 0
+    self.set_max_output_buffer(4096)
+
+  def work (self, input_items, output_items):
+    n = len(output_items[0])
+    if self.sent == self.index:
+      self.action()
+    elif self.sent < self.index:
+      n = min(n, self.index - self.sent)
+    output_items[0][:n] = input_items[0][:n]
+    self.sent += n
+    return n
+
 class qa_decode (gr_unittest.TestCase):
 
     def setUp (self):
@@ -50,8 +74,8 @@ class qa_decode (gr_unittest.TestCase):
     def tearDown (self):
         self.tb = None
 
-    def _run_test (self, src_block, tolerance):
-      decode = ook.decode(tolerance)
+    def _run_test (self, src_block, tolerance, decoder=ook.decode):
+      decode = decoder(tolerance)
       out = blocks.message_debug()
       self.tb.connect(src_block, decode)
       self.tb.msg_connect(decode, "packet", out, "store")
@@ -72,24 +96,70 @@ class qa_decode (gr_unittest.TestCase):
       self.assertEqual(packets[0]['valid_check'], True)
       self.assertEqual(packets[0]['bit_count'], 8 * len(data))
 
-    def _file_test (self, test_spec):
+    def _file_test (self, test_spec, split=False):
       src = blocks.file_source(
           gr.sizeof_float * 1,
           str(os.path.join(samples_dir, test_spec['name'])),
           False
       )
-      packets = self._run_test(src, test_spec['tolerance'])
+      decoder = ook.decode
+      if split:
+        edges = ook.edge_detector()
+        self.tb.connect(src, edges)
+        src, decoder = edges, ook.run_decoder
+      packets = self._run_test(src, test_spec['tolerance'], decoder)
       self.assertEqual(packets, test_spec['packets'])
 
-    def test_samples (self):
-      tests = json.load(
+    def _load_specs (self):
+      return json.load(
         open(os.path.join(samples_dir, 'decode-tests.json')),
         object_hook=de_unicode
       )
 
-      for test_spec in tests:
+    def test_samples (self):
+      for test_spec in self._load_specs():
         self._file_test(test_spec)
 
+    def test_split_samples (self):
+      for test_spec in self._load_specs():
+        self._file_test(test_spec, split=True)
+
+    def _buffer_packets (self, packets):
+      for packet in packets:
+        packet['data'] = list(bytearray(packet['data']))
+      return packets
+
+    def test_decode_buffer (self):
+      for test_spec in self._load_specs():
+        samples = numpy.fromfile(
+          os.path.join(samples_dir, test_spec['name']), dtype=numpy.float32)
+        packets = ook.decode_buffer(samples, test_spec['tolerance'])
+        self.assertEqual(self._buffer_packets(packets), test_spec['packets'])
+
+    def test_stream_decoder (self):
+      for test_spec in self._load_specs():
+        samples = numpy.fromfile(
+          os.path.join(samples_dir, test_spec['name']), dtype=numpy.float32)
+        decoder = ook.stream_decoder(test_spec['tolerance'])
+        packets = []
+        for start in range(0, len(samples), 1000):
+          packets += decoder.feed(samples[start:start + 1000])
+        packets += decoder.flush()
+        self.assertEqual(self._buffer_packets(packets), test_spec['packets'])
+
+        # Input after a flush is numbered on from where the flush was,
+        # even if the flush came in the middle of an attempt.
+        pulse = numpy.array([1] * 10 + [0] * 50, dtype=numpy.float32)
+        packets = decoder.feed(samples) + decoder.flush()
+        packets += decoder.feed(pulse) + decoder.flush()
+        packets += decoder.feed(samples) + decoder.flush()
+        expected = []
+        for offset in [len(samples), 2 * len(samples) + len(pulse)]:
+          expected += [dict(p, start_sample=p['start_sample'] + offset,
+                            end_sample=p['end_sample'] + offset)
+                       for p in test_spec['packets']]
+        self.assertEqual(self._buffer_packets(packets), expected)
+
     def test_random (self):
       src = blocks.file_source(
           gr.sizeof_float * 1,
@@ -111,6 +181,562 @@ class qa_decode (gr_unittest.TestCase):
       self._data_test([0xAA] * 5)
       self._data_test([0x12, 0x34, 0x56, 0x78, 0x9A])
 
+    def test_modulator (self):
+      data = [0x12, 0x34, 0x56, 0x78, 0x9A]
+      src = blocks.vector_source_b(data * 3, False)
+      tagger = blocks.stream_to_tagged_stream(
+        gr.sizeof_char, 1, len(data), "packet_len")
+      modulator = ook.modulator()
+      self.tb.connect(src, tagger, modulator)
+      packets = self._run_test(modulator, tolerance=0.1)
+      self.assertEqual(len(packets), 3)
+      for packet in packets:
+        self.assertEqual(packet['data'], data)
+        self.assertEqual(packet['valid_check'], True)
+
+    def test_fixed_point (self):
+      data = [0x12, 0x34, 0x56, 0x78, 0x9A]
+      variants = [
+        (lambda: blocks.float_to_short(1, 32767), ook.decode_s),
+        (lambda: blocks.float_to_char(1, 127), ook.decode_b),
+      ]
+      for make_convert, decoder in variants:
+        self.tb = gr.top_block()
+        convert = make_convert()
+        self.tb.connect(ook.packet_source(data), convert)
+        packets = self._run_test(convert, 0.1, decoder)
+        self.assertEqual(len(packets), 1)
+        self.assertEqual(packets[0]['data'], data)
+        self.assertEqual(packets[0]['valid_check'], True)
+
+    def test_complex_output (self):
+      # The keyed carrier demodulates back to the envelope.
+      data = [0x12, 0x34, 0x56, 0x78, 0x9A]
+      variants = [
+        ('complex', lambda: [], 1.0),
+        ('sc16', lambda: [blocks.interleaved_short_to_complex(True)], 32767),
+        ('sc8', lambda: [blocks.interleaved_char_to_complex(True)], 127),
+      ]
+      for fmt, make_convert, full_scale in variants:
+        self.tb = gr.top_block()
+        chain = [ook.packet_source(data, 1, 10, 32000, fmt, -3000, 0.8)]
+        chain += make_convert()
+        chain += [
+          blocks.complex_to_mag(),
+          blocks.multiply_const_ff(1.0 / full_scale),
+        ]
+        self.tb.connect(*chain)
+        packets = self._run_test(chain[-1], 0.1)
+        self.assertEqual(len(packets), 1)
+        self.assertEqual(packets[0]['data'], data)
+        self.assertEqual(packets[0]['valid_check'], True)
+
+    def test_latency (self):
+      test_spec = self._load_specs()[-1]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      decode = ook.decode(tolerance=test_spec['tolerance'], timestamps=True)
+      out = blocks.message_debug()
+      self.tb.connect(src, decode)
+      self.tb.msg_connect(decode, "packet", out, "store")
+      self.tb.run()
+
+      self.assertEqual(out.num_messages(), len(test_spec['packets']))
+      for i, expected in enumerate(test_spec['packets']):
+        packet = pmt.to_python(out.get_message(i))
+        self.assertEqual(packet['start_sample'], expected['start_sample'])
+        self.assertEqual(packet['end_sample'], expected['end_sample'])
+        self.assertGreaterEqual(packet['publish_time'], packet['sample_time'])
+      self.assertEqual(
+        sum(decode.latency_histogram()), len(test_spec['packets']))
+
+    def test_expected_length (self):
+      for test_spec in self._load_specs():
+        for expected_bits, learn in [([], True), ([92, 132], False)]:
+          self.tb = gr.top_block()
+          src = blocks.file_source(
+              gr.sizeof_float * 1,
+              str(os.path.join(samples_dir, test_spec['name'])),
+              False
+          )
+          decode = ook.decode(
+            tolerance=test_spec['tolerance'], expected_bits=expected_bits,
+            learn_lengths=learn)
+          out = blocks.message_debug()
+          self.tb.connect(src, decode)
+          self.tb.msg_connect(decode, "packet", out, "store")
+          self.tb.run()
+
+          self.assertEqual(out.num_messages(), len(test_spec['packets']))
+          for i, expected in enumerate(test_spec['packets']):
+            packet = pmt.to_python(out.get_message(i))
+            self.assertEqual(packet['pretty'], expected['pretty'])
+            self.assertEqual(packet['phy_pretty'], expected['phy_pretty'])
+            if expected_bits or i > 0:
+              self.assertLess(packet['end_sample'], expected['end_sample'])
+            else:
+              self.assertEqual(packet['end_sample'], expected['end_sample'])
+
+    def _waveform (self, data, ms=32):
+      runs = [(ms, 1), (ms, 0)] * 40 + [(ms, 1)]
+      bits = [(ms if (byte >> (7 - bit)) & 1 else ms // 2, bit & 1)
+              for byte in data for bit in range(8)]
+      preamble = [(2 * ms, 0), (2 * ms, 1)]
+      runs += preamble + bits + preamble + bits + [(80 * ms, 0)]
+      return runs
+
+    def _samples (self, runs):
+      return numpy.concatenate(
+        [numpy.full(n, level, dtype=numpy.float32) for n, level in runs])
+
+    def test_sync_lookback (self):
+      # A noise pulse just before the sync train used to capture the
+      # sync search and make the decoder miss the packet.
+      data = [0x12, 0x34, 0x56, 0x78, 0x9A]
+      noise = [[(20, 1), (23, 0)], [(50, 1), (21, 0), (21, 1), (17, 0)]]
+      for prefix in noise:
+        samples = self._samples(prefix + self._waveform(data))
+        packets = [p for p in ook.decode_buffer(samples, 0.1)
+                   if p['valid_check']]
+        self.assertEqual(len(packets), 1)
+        self.assertEqual(list(bytearray(packets[0]['data'])), data)
+        self.assertEqual(packets[0]['start_sample'], sum(n for n, _ in prefix))
+
+    def test_pulse_limits (self):
+      data = [0x12, 0x34, 0x56, 0x78, 0x9A]
+      samples = self._samples(self._waveform(data))
+      cases = [
+        (dict(min_width_us=500, max_width_us=2000, min_sync_count=8), 1),
+        (dict(min_width_us=1500, max_width_us=3000), 0),
+        (dict(min_width_us=200, max_width_us=600), 0),
+        (dict(min_sync_count=41), 0),
+      ]
+      for limits, count in cases:
+        self.tb = gr.top_block()
+        decode = ook.decode(sample_rate=32000, **limits)
+        out = blocks.message_debug()
+        self.tb.connect(blocks.vector_source_f(samples.tolist()), decode)
+        self.tb.msg_connect(decode, "packet", out, "store")
+        self.tb.run()
+
+        self.assertEqual(out.num_messages(), count)
+        if count:
+          packet = pmt.to_python(out.get_message(0))
+          self.assertEqual(packet['sync_width'], 32)
+          self.assertAlmostEqual(packet['sync_width_us'], 1000.0)
+
+    def test_batching (self):
+      test_spec = self._load_specs()[-1]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      decode = ook.decode(
+        tolerance=test_spec['tolerance'], batch_size=16, batch_timeout_ms=1e6)
+      single = blocks.message_debug()
+      batches = blocks.message_debug()
+      self.tb.connect(src, decode)
+      self.tb.msg_connect(decode, "packet", single, "store")
+      self.tb.msg_connect(decode, "packets", batches, "store")
+      self.tb.run()
+
+      self.assertEqual(single.num_messages(), 0)
+      self.assertEqual(batches.num_messages(), 1)
+      packets = pmt.to_python(batches.get_message(0))
+      self.assertEqual(len(packets), len(test_spec['packets']))
+      for packet, expected in zip(packets, test_spec['packets']):
+        packet['data'] = packet['data'].tolist()
+        self.assertEqual(packet, expected)
+
+    def test_overload (self):
+      test_spec = self._load_specs()[-1]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      # Any measurable load exceeds the maximum, so the decoder degrades
+      # after the first tenth of a second of input.
+      decode = ook.decode(
+        tolerance=test_spec['tolerance'], sample_rate=1e5, max_load=1e-9)
+      packets = blocks.message_debug()
+      overload = blocks.message_debug()
+      self.tb.connect(src, decode)
+      self.tb.msg_connect(decode, "packet", packets, "store")
+      self.tb.msg_connect(decode, "overload", overload, "store")
+      self.tb.run()
+
+      self.assertGreaterEqual(overload.num_messages(), 1)
+      event = pmt.to_python(overload.get_message(0))
+      self.assertTrue(event['overloaded'])
+      self.assertGreater(event['load'], 0)
+
+      self.assertEqual(packets.num_messages(), len(test_spec['packets']))
+      for i, expected in enumerate(test_spec['packets']):
+        packet = pmt.to_python(packets.get_message(i))
+        self.assertEqual(packet['data'].tolist(), expected['data'])
+        self.assertEqual(packet['valid_check'], expected['valid_check'])
+      self.assertEqual(packet['pretty'], '')
+
+    def test_levels (self):
+      test_spec = self._load_specs()[1]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      decode = ook.decode(tolerance=test_spec['tolerance'], levels=True)
+      out = blocks.message_debug()
+      self.tb.connect(src, decode)
+      self.tb.msg_connect(decode, "packet", out, "store")
+      self.tb.run()
+
+      self.assertEqual(out.num_messages(), len(test_spec['packets']))
+      packet = pmt.to_python(out.get_message(0))
+      self.assertAlmostEqual(packet['rssi'], 0.996, places=3)
+      self.assertAlmostEqual(packet['noise'], 0.001, places=3)
+      self.assertAlmostEqual(packet['snr'], 32.7, places=1)
+
+    def test_interpolate (self):
+      # Decimated to about four samples per short pulse, whole-sample
+      # timing cannot tell the bits apart.
+      decimation = 24
+      test_spec = self._load_specs()[1]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      average = blocks.moving_average_ff(decimation, 1.0 / decimation)
+      keep = blocks.keep_one_in_n(gr.sizeof_float, decimation)
+      decode = ook.decode(tolerance=test_spec['tolerance'], interpolate=True)
+      out = blocks.message_debug()
+      self.tb.connect(src, average, keep, decode)
+      self.tb.msg_connect(decode, "packet", out, "store")
+      self.tb.run()
+
+      self.assertEqual(out.num_messages(), len(test_spec['packets']))
+      for i, expected in enumerate(test_spec['packets']):
+        packet = pmt.to_python(out.get_message(i))
+        self.assertEqual(packet['data'].tolist(), expected['data'])
+        self.assertTrue(packet['valid_check'])
+        self.assertAlmostEqual(
+          packet['sync_width'], expected['sync_width'] / decimation, delta=1)
+
+    def test_squelch (self):
+      # Idle spans are skipped, but the packets and their positions must
+      # come out exactly as without the squelch.
+      for test_spec in self._load_specs():
+        self.tb = gr.top_block()
+        src = blocks.file_source(
+            gr.sizeof_float * 1,
+            str(os.path.join(samples_dir, test_spec['name'])),
+            False
+        )
+        decoder = lambda tolerance: ook.decode(
+          tolerance=tolerance, squelch=0.2)
+        packets = self._run_test(src, test_spec['tolerance'], decoder)
+        self.assertEqual(packets, test_spec['packets'])
+
+    def test_sync_correlation (self):
+      # A noise spike in every sync gap breaks the pulse-by-pulse search,
+      # but the matched filter still finds the sync train.
+      data = [0x12, 0x34, 0x56, 0x78, 0x9A]
+      runs = self._waveform(data)
+      sync = [(32, 1), (15, 0), (2, 1), (15, 0)] * 40
+      samples = self._samples(sync + runs[80:])
+      for correlation, count in [(0, 0), (0.5, 1)]:
+        self.tb = gr.top_block()
+        decode = ook.decode(
+          sample_rate=32000, min_width_us=500, max_width_us=2000,
+          sync_correlation=correlation)
+        out = blocks.message_debug()
+        self.tb.connect(blocks.vector_source_f(samples.tolist()), decode)
+        self.tb.msg_connect(decode, "packet", out, "store")
+        self.tb.run()
+
+        self.assertEqual(out.num_messages(), count)
+        if count:
+          packet = pmt.to_python(out.get_message(0))
+          self.assertEqual(packet['data'].tolist(), data)
+          self.assertTrue(packet['valid_check'])
+          self.assertEqual(packet['start_sample'], 0)
+
+    def test_config (self):
+      # Settings made after construction take effect on the next packet.
+      for test_spec in self._load_specs():
+        self.tb = gr.top_block()
+        src = blocks.file_source(
+            gr.sizeof_float * 1,
+            str(os.path.join(samples_dir, test_spec['name'])),
+            False
+        )
+        def decoder (tolerance):
+          decode = ook.decode(0.01, 0.9)
+          decode.set_tolerance(tolerance)
+          decode.set_threshold(0.5)
+          decode.set_verbose(False)
+          return decode
+        packets = self._run_test(src, test_spec['tolerance'], decoder)
+        self.assertEqual(packets, test_spec['packets'])
+
+      self.tb = gr.top_block()
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      def limited (tolerance):
+        decode = ook.decode(tolerance)
+        decode.set_limits(0, 0, 41)
+        return decode
+      self.assertEqual(
+        self._run_test(src, test_spec['tolerance'], limited), [])
+
+      # A threshold raised halfway through a packet waits for the packet
+      # to end. The next packet is too weak for it, the one after is not.
+      sent = [([0x12, 0x34, 0x56, 0x78, 0x9A], 0.7),
+              ([0x9A, 0x78, 0x56, 0x34, 0x12], 0.7),
+              ([0x55, 0xAA, 0x55, 0xAA, 0x55], 1.0)]
+      samples = [self._samples(self._waveform(data, 320)) * level
+                 for data, level in sent]
+      self.tb = gr.top_block()
+      decode = ook.decode(0.1, 0.5)
+      switch = at_sample(
+        len(samples[0]) // 2, lambda: decode.set_threshold(0.9))
+      self.tb.connect(
+        blocks.vector_source_f(numpy.concatenate(samples).tolist()), switch)
+      packets = self._run_test(switch, 0.1, lambda tolerance: decode)
+      self.assertEqual(
+        [p['data'] for p in packets], [sent[0][0], sent[2][0]])
+
+    def test_flight_recorder (self):
+      test_spec = self._load_specs()[-1]
+      samples = numpy.fromfile(
+        os.path.join(samples_dir, test_spec['name']), dtype=numpy.float32)
+      # Hold the first packet high in the middle of its data.
+      samples[30000:30100] = 1.0
+      tmp = tempfile.mkdtemp()
+      try:
+        src = blocks.vector_source_f(samples.tolist())
+        decode = ook.decode(
+          tolerance=test_spec['tolerance'],
+          record_prefix=os.path.join(tmp, 'rec'), record_ring=1 << 16,
+          record_files=4)
+        out = blocks.message_debug()
+        self.tb.connect(src, decode)
+        self.tb.msg_connect(decode, "packet", out, "store")
+        self.tb.run()
+
+        self.assertEqual(out.num_messages(), len(test_spec['packets']) - 1)
+        with open(os.path.join(tmp, 'rec.0.json')) as f:
+          info = json.load(f)
+        self.assertEqual(
+          info['sync_sample'], test_spec['packets'][0]['start_sample'])
+        self.assertLessEqual(info['failed_sample'], 30100)
+        window = numpy.fromfile(
+          os.path.join(tmp, 'rec.0.f32'), dtype=numpy.float32)
+        self.assertEqual(len(window), info['samples'])
+        start = info['start_sample']
+        self.assertTrue(
+          numpy.array_equal(window, samples[start:start + len(window)]))
+      finally:
+        shutil.rmtree(tmp)
+
+    def test_multi_decode (self):
+      test_spec = self._load_specs()[-1]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      channels = 10
+      to_vector = blocks.streams_to_vector(gr.sizeof_float, channels)
+      decode = ook.multi_decode(channels, test_spec['tolerance'])
+      dst = blocks.message_debug()
+      for i in range(channels):
+        self.tb.connect(src, (to_vector, i))
+      self.tb.connect(to_vector, decode)
+      self.tb.msg_connect(decode, "packet", dst, "store")
+      self.tb.run()
+
+      self.assertEqual(
+        dst.num_messages(), channels * len(test_spec['packets']))
+      for i in range(dst.num_messages()):
+        packet = pmt.to_python(dst.get_message(i))
+        channel = packet.pop('channel')
+        self.assertTrue(0 <= channel < channels)
+        packet['data'] = packet['data'].tolist()
+        self.assertIn(packet, test_spec['packets'])
+
+    def test_packet_router (self):
+      test_spec = self._load_specs()[-1]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      decode = ook.decode(test_spec['tolerance'])
+      router = ook.packet_router(
+        ['fob=33a0888c', 'keypad=33a0 xx8c 7272/ffff00ff fffe', 'any=33'],
+        True, 100)
+      sinks = dict((port, blocks.message_debug())
+                   for port in ['fob', 'keypad', 'any', 'unmatched'])
+      self.tb.connect(src, decode)
+      self.tb.msg_connect(decode, "packet", router, "packet")
+      for port, sink in sinks.items():
+        self.tb.msg_connect(router, port, sink, "store")
+      self.tb.run()
+
+      self.assertEqual(sinks['fob'].num_messages(), 0)
+      self.assertEqual(sinks['any'].num_messages(), 0)
+      self.assertEqual(sinks['unmatched'].num_messages(), 0)
+      self.assertEqual(
+        sinks['keypad'].num_messages(), len(test_spec['packets']))
+
+    def _check_decoder (self, decode):
+      self.tb = gr.top_block()
+      payloads = [[0x12, 0x34], [0x56, 0x78, 0x9a], [0xbc]]
+      src = ook.packet_source(payloads[0], -1)
+      checker = ook.decode_checker()
+      self.tb.connect(src, decode)
+      self.tb.connect(src, checker)
+      self.tb.msg_connect(decode, "packet", checker, "packet")
+      for payload in payloads[1:]:
+        src.to_basic_block()._post(
+          pmt.intern("packets"), pmt.init_u8vector(len(payload), payload))
+      # Nothing was sent at sample 10, so this is a false positive.
+      checker.to_basic_block()._post(
+        pmt.intern("packet"),
+        pmt.to_pmt({'data': numpy.array([0xbc], dtype=numpy.uint8),
+                    'start_sample': 0, 'end_sample': 10}))
+      self.tb.start()
+      for i in range(100):
+        if checker.detected() == len(payloads):
+          break
+        sleep(0.05)
+      self.tb.stop()
+      self.tb.wait()
+
+      self.assertEqual(checker.transmitted(), len(payloads))
+      self.assertEqual(checker.detected(), len(payloads))
+      self.assertEqual(checker.detection_rate(), 1.0)
+      self.assertEqual(checker.false_positives(), 1)
+      return checker.latencies()
+
+    def test_decode_checker (self):
+      latencies = self._check_decoder(ook.decode())
+      self.assertEqual(len(set(latencies)), 1)
+      # Publishing at the last bit beats waiting for the trailing silence.
+      early = self._check_decoder(ook.decode(expected_bits=[16, 24, 8]))
+      self.assertLess(max(early), min(latencies))
+
+    def test_packet_log (self):
+      test_spec = self._load_specs()[0]
+      src = blocks.file_source(
+          gr.sizeof_float * 1,
+          str(os.path.join(samples_dir, test_spec['name'])),
+          False
+      )
+      tmp = tempfile.mkdtemp()
+      try:
+        decode = ook.decode(test_spec['tolerance'])
+        sink = ook.packet_log_sink(os.path.join(tmp, 'log'), 1)
+        self.tb.connect(src, decode)
+        self.tb.msg_connect(decode, "packet", sink, "packet")
+        self.tb.run()
+        self.tb = None
+        sink = None
+
+        records = []
+        for path in sorted(glob.glob(os.path.join(tmp, 'log.*.ooklog'))):
+          records += packet_log.read(path)
+        self.assertEqual(len(records), len(test_spec['packets']))
+        for record, expected in zip(records, test_spec['packets']):
+          self.assertEqual(list(bytearray(record.data)), expected['data'])
+          self.assertEqual(record.bit_count, expected['bit_count'])
+          self.assertEqual(record.sync_count, expected['sync_count'])
+          self.assertEqual(record.valid_check, expected['valid_check'])
+          self.assertEqual(record.sample_offset, expected['start_sample'])
+      finally:
+        shutil.rmtree(tmp)
+
+    def test_rl_capture (self):
+      tmp = tempfile.mkdtemp()
+      try:
+        for test_spec in self._load_specs():
+          name = os.path.join(samples_dir, test_spec['name'])
+          path = os.path.join(tmp, test_spec['name'] + '.ookrl')
+          self.tb = gr.top_block()
+          src = blocks.file_source(gr.sizeof_float * 1, str(name), False)
+          self.tb.connect(src, ook.rl_capture_sink(path, 0.5, 0, 8))
+          self.tb.run()
+          self.tb = gr.top_block()
+          self.assertLess(
+            os.path.getsize(path) * 50, os.path.getsize(name))
+
+          # Decode the runs directly, then the replayed envelope.
+          src = ook.rl_capture_source(path)
+          packets = self._run_test(
+            src, test_spec['tolerance'], ook.run_decoder)
+          self.assertEqual(packets, test_spec['packets'])
+          self.tb = gr.top_block()
+          src = ook.rl_capture_source(path, True)
+          packets = self._run_test(src, test_spec['tolerance'])
+          self.assertEqual(packets, test_spec['packets'])
+
+        # Running the flowgraph again extends the capture.
+        test_spec = self._load_specs()[0]
+        samples = numpy.fromfile(
+          os.path.join(samples_dir, test_spec['name']), dtype=numpy.float32)
+        path = os.path.join(tmp, 'twice.ookrl')
+        self.tb = gr.top_block()
+        src = blocks.vector_source_f(samples.tolist())
+        self.tb.connect(src, ook.rl_capture_sink(path, 0.5))
+        self.tb.run()
+        src.rewind()
+        self.tb.run()
+        self.tb = gr.top_block()
+        packets = self._run_test(
+          ook.rl_capture_source(path), test_spec['tolerance'],
+          ook.run_decoder)
+        expected = [dict(p, start_sample=p['start_sample'] + len(samples),
+                         end_sample=p['end_sample'] + len(samples))
+                    for p in test_spec['packets']]
+        self.assertEqual(packets, test_spec['packets'] + expected)
+      finally:
+        shutil.rmtree(tmp)
+
+    def test_decoded_reconnect (self):
+      # Each writer to a named pipe is decoded from sample zero.
+      test_spec = self._load_specs()[0]
+      samples = open(os.path.join(samples_dir, test_spec['name']), 'rb').read()
+      tmp = tempfile.mkdtemp()
+      fifo = os.path.join(tmp, 'in')
+      os.mkfifo(fifo)
+      daemon = subprocess.Popen(
+        [os.environ['OOK_DECODED'], '-t', str(test_spec['tolerance']), fifo],
+        stdout=subprocess.PIPE)
+      try:
+        for writer in range(3):
+          with open(fifo, 'wb') as f:
+            f.write(samples)
+          for expected in test_spec['packets']:
+            packet = json.loads(daemon.stdout.readline())
+            self.assertEqual(packet['start_sample'], expected['start_sample'])
+            self.assertEqual(packet['end_sample'], expected['end_sample'])
+            self.assertEqual(packet['bit_count'], expected['bit_count'])
+          # Let the daemon see the end of this writer before the next.
+          sleep(0.5)
+      finally:
+        daemon.terminate()
+        daemon.wait()
+        shutil.rmtree(tmp)
+
 
 if __name__ == '__main__':
     gr_unittest.run(qa_decode, "qa_decode.xml")
@@ -9,10 +9,168 @@
 
 %{
 #include "ook/decode.h"
+#include "ook/decode_checker.h"
+#include "ook/edge_detector.h"
+#include "ook/modulator.h"
+#include "ook/multi_decode.h"
+#include "ook/packet_log_sink.h"
+#include "ook/packet_router.h"
 #include "ook/packet_source.h"
+#include "ook/rl_capture_sink.h"
+#include "ook/rl_capture_source.h"
+#include "ook/run_decoder.h"
+#include "ook/stream_decoder.h"
 %}
 
+/* Latency histograms are returned as plain lists. */
+%typemap(out) std::vector<std::uint64_t> {
+    $result = PyList_New($1.size());
+    if (!$result) {
+        SWIG_fail;
+    }
+    for (size_t i = 0; i < $1.size(); ++i) {
+        PyList_SET_ITEM($result, i, PyLong_FromUnsignedLongLong($1[i]));
+    }
+}
+
+/* decode takes many optional settings; let Python name the ones it sets. */
+%feature("kwargs") gr::ook::decode_blk::make;
+
 %include "ook/decode.h"
+%include "ook/decode_checker.h"
+%include "ook/edge_detector.h"
+%include "ook/modulator.h"
+%include "ook/multi_decode.h"
+%include "ook/packet_log_sink.h"
+%include "ook/packet_router.h"
 %include "ook/packet_source.h"
-GR_SWIG_BLOCK_MAGIC2(ook, decode);
+%include "ook/rl_capture_sink.h"
+%include "ook/rl_capture_source.h"
+%include "ook/run_decoder.h"
+GR_SWIG_BLOCK_MAGIC2_TMPL(ook, decode, decode_blk<float>);
+GR_SWIG_BLOCK_MAGIC2_TMPL(ook, decode_s, decode_blk<std::int16_t>);
+GR_SWIG_BLOCK_MAGIC2_TMPL(ook, decode_b, decode_blk<std::int8_t>);
+GR_SWIG_BLOCK_MAGIC2(ook, decode_checker);
+GR_SWIG_BLOCK_MAGIC2(ook, edge_detector);
+GR_SWIG_BLOCK_MAGIC2(ook, modulator);
+GR_SWIG_BLOCK_MAGIC2(ook, multi_decode);
+GR_SWIG_BLOCK_MAGIC2(ook, packet_log_sink);
+GR_SWIG_BLOCK_MAGIC2(ook, packet_router);
 GR_SWIG_BLOCK_MAGIC2(ook, packet_source);
+GR_SWIG_BLOCK_MAGIC2(ook, rl_capture_sink);
+GR_SWIG_BLOCK_MAGIC2(ook, rl_capture_source);
+GR_SWIG_BLOCK_MAGIC2(ook, run_decoder);
+
+/*
+ * Direct decoding of numpy (or any buffer protocol) float32 arrays,
+ * without building a flowgraph. Samples are read in place and packets
+ * come back as plain dictionaries with the same keys as the PMT
+ * dictionaries published by the blocks.
+ */
+%{
+namespace {
+bool ook_get_float_buffer(PyObject* obj, Py_buffer* view)
+{
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        return false;
+    }
+
+    if (view->itemsize != sizeof(float) || !view->format ||
+        std::string(view->format) != "f") {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_TypeError, "expected a contiguous float32 buffer");
+        return false;
+    }
+    return true;
+}
+
+bool ook_dict_set(PyObject* dict, const char* key, PyObject* value)
+{
+    if (!value) {
+        return false;
+    }
+    int result = PyDict_SetItemString(dict, key, value);
+    Py_DECREF(value);
+    return result == 0;
+}
+
+PyObject* ook_packet_to_python(const gr::ook::packet& p)
+{
+    PyObject* result = PyDict_New();
+    if (!result) {
+        return NULL;
+    }
+
+    bool ok =
+      ook_dict_set(result, "data", PyBytes_FromStringAndSize(
+        (const char*)p.data.data(), p.data.size())) &&
+      ook_dict_set(result, "bit_count", PyLong_FromSize_t(p.bit_count)) &&
+      ook_dict_set(result, "sync_count", PyLong_FromLong(p.sync_count)) &&
+      ook_dict_set(result, "sync_width", PyLong_FromLong(p.sync_width)) &&
+      ook_dict_set(result, "valid_check", PyBool_FromLong(p.valid_check)) &&
+      ook_dict_set(
+        result, "start_sample", PyLong_FromUnsignedLongLong(p.start_sample)) &&
+      ook_dict_set(
+        result, "end_sample", PyLong_FromUnsignedLongLong(p.end_sample)) &&
+      ook_dict_set(result, "pretty", PyUnicode_FromString(p.pretty.c_str())) &&
+      ook_dict_set(
+        result, "phy_pretty", PyUnicode_FromString(p.phy_pretty.c_str()));
+    if (ok && p.sync_width_us > 0) {
+        ok = ook_dict_set(
+          result, "sync_width_us", PyFloat_FromDouble(p.sync_width_us));
+    }
+    if (ok && p.has_levels) {
+        ok = ook_dict_set(result, "rssi", PyFloat_FromDouble(p.rssi)) &&
+          ook_dict_set(result, "noise", PyFloat_FromDouble(p.noise)) &&
+          ook_dict_set(result, "snr", PyFloat_FromDouble(p.snr));
+    }
+
+    if (!ok) {
+        Py_DECREF(result);
+        return NULL;
+    }
+    return result;
+}
+
+PyObject* ook_packets_to_python(const std::vector<gr::ook::packet>& packets)
+{
+    PyObject* result = PyList_New(packets.size());
+    if (!result) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < packets.size(); ++i) {
+        PyObject* item = ook_packet_to_python(packets[i]);
+        if (!item) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, item);
+    }
+    return result;
+}
+}
+%}
+
+%typemap(in) (const float* samples, size_t count) (Py_buffer view) {
+    if (!ook_get_float_buffer($input, &view)) {
+        SWIG_fail;
+    }
+    $1 = (float*)view.buf;
+    $2 = (size_t)(view.len / sizeof(float));
+}
+
+%typemap(freearg) (const float* samples, size_t count) {
+    if ($1) {
+        PyBuffer_Release(&view$argnum);
+    }
+}
+
+%typemap(out) std::vector<gr::ook::packet> {
+    $result = ook_packets_to_python($1);
+    if (!$result) {
+        SWIG_fail;
+    }
+}
+
+%include "ook/stream_decoder.h"